@@ -35,12 +35,18 @@ for any real secure purposes. You have been warned!
 
 
 #include "ANGELITA128.h"
+#include "ANGELITA128_Scheduler.h"
 #include <iostream>
 #include <vector>
 #include <fstream>
 #include <regex>
 #include <sstream>
 #include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 std::array<unsigned char, 9728> ANGELITA128::sp1_8(std::array<unsigned char, 1216> bytes) {
 	//Split list of Key Schedule bytes into bits for use in TeaParty2 for the S-Box
@@ -72,7 +78,7 @@ std::array<unsigned char, 2560> ANGELITA128::sp1_8(std::array<unsigned char, 320
 	return bits;
 }
 
-std::array<unsigned char, 64> ANGELITA128::sp1_4(std::array<unsigned char, 16> bytes) {
+std::array<unsigned char, 64> ANGELITA128::sp1_4(std::array<unsigned char, 16> bytes) const {
 	//Split a block of bytes into a block of 2-bits
 	std::array<unsigned char, 64> twoBits;
 	for (int n = 0, m = 0; m < 64; n++) {
@@ -88,7 +94,7 @@ std::array<unsigned char, 64> ANGELITA128::sp1_4(std::array<unsigned char, 16> b
 	return twoBits;
 }
 
-std::array<unsigned char, 16> ANGELITA128::jn4_1(std::array<unsigned char, 64> twoBits) {
+std::array<unsigned char, 16> ANGELITA128::jn4_1(std::array<unsigned char, 64> twoBits) const {
 	//Join a block of 2-bits into a block of bytes
 	std::array<unsigned char, 16> bytes;
 	for (int n = 0, m = 0; m < 64; n++) {
@@ -221,6 +227,27 @@ void ANGELITA128::genRevPbox() {
 	this->revPbox = rpbox;
 }
 
+void ANGELITA128::genPboxTables() {
+	//Precompute the P-Box and reverse P-Box for each byte of a block
+	//For every byte position and value the entry is a block with only those four 2-bits moved
+	//to where the box puts them, so permuting a block is 16 lookups XORed together
+	for (unsigned int n = 0; n < 16; n++) {
+		for (unsigned int v = 0; v < 256; v++) {
+			std::array<unsigned char, 16> moved = {};
+			std::array<unsigned char, 16> revMoved = {};
+			for (unsigned int j = 0; j < 4; j++) {
+				unsigned int twoBit = (v >> (6 - 2 * j)) & 3;
+				unsigned int to = this->Pbox[n * 4 + j];
+				moved[to / 4] |= twoBit << (6 - 2 * (to % 4));
+				to = this->revPbox[n * 4 + j];
+				revMoved[to / 4] |= twoBit << (6 - 2 * (to % 4));
+			}
+			std::memcpy(this->PboxTable[n * 256 + v].data(), moved.data(), 16);
+			std::memcpy(this->revPboxTable[n * 256 + v].data(), revMoved.data(), 16);
+		}
+	}
+}
+
 std::array<unsigned char, 2048> ANGELITA128::ANGELITA128_KISS() {
 	//Expands the 128-bit key 128 times
 	//First generate 256 bytes from the initial key by repeated XOR of 1 byte per block
@@ -439,12 +466,12 @@ void ANGELITA128::genKS() {
 }
 
 
-unsigned char ANGELITA128::useSBox(unsigned char blockByte) {
+unsigned char ANGELITA128::useSBox(unsigned char blockByte) const {
 	//S-Box, substitute input byte with byte from the S-Box
 	return this->Sbox[blockByte];
 }
 
-std::array<unsigned char, 64> ANGELITA128::usePBox(std::array<unsigned char, 64> twoBits) {
+std::array<unsigned char, 64> ANGELITA128::usePBox(std::array<unsigned char, 64> twoBits) const {
 	//P-Box, permute the input 2-bits according to the P-Box indexes
 	std::array<unsigned char, 64> pTwoBits;
 	for (unsigned int i = 0; i < 64; i++) {
@@ -453,12 +480,12 @@ std::array<unsigned char, 64> ANGELITA128::usePBox(std::array<unsigned char, 64>
 	return pTwoBits;
 }
 
-unsigned char ANGELITA128::useRevSBox(unsigned char blockByte) {
+unsigned char ANGELITA128::useRevSBox(unsigned char blockByte) const {
 	//Reverse S-Box, substitute input byte with byte from reverse S-Box
 	return this->revSbox[blockByte];
 }
 
-std::array<unsigned char, 64> ANGELITA128::useRevPBox(std::array<unsigned char, 64> twoBits) {
+std::array<unsigned char, 64> ANGELITA128::useRevPBox(std::array<unsigned char, 64> twoBits) const {
 	//Reverse P-Box, permute the input 2-bits according to the reverse P-Box indexes
 	std::array<unsigned char, 64> pTwoBits;
 	for (unsigned int i = 0; i < 64; i++) {
@@ -467,7 +494,7 @@ std::array<unsigned char, 64> ANGELITA128::useRevPBox(std::array<unsigned char,
 	return pTwoBits;
 }
 
-std::array<unsigned char, 16> ANGELITA128::encrypt(std::array<unsigned char, 16> plaintextBlock) {
+std::array<unsigned char, 16> ANGELITA128::encrypt(std::array<unsigned char, 16> plaintextBlock) const {
 	//Encryption routine
 	//16 cycles:
 	//XOR with Key Schedule byte 1
@@ -489,7 +516,7 @@ std::array<unsigned char, 16> ANGELITA128::encrypt(std::array<unsigned char, 16>
 	return plaintextBlock;
 }
 
-std::array<unsigned char, 16> ANGELITA128::decrypt(std::array<unsigned char, 16> ciphertextBlock) {
+std::array<unsigned char, 16> ANGELITA128::decrypt(std::array<unsigned char, 16> ciphertextBlock) const {
 	//Decryption routine
 	//16 cycles going 16..0 (Decreasing):
 	//Every cycles mod 2 == 0, reverse P-Box
@@ -511,6 +538,61 @@ std::array<unsigned char, 16> ANGELITA128::decrypt(std::array<unsigned char, 16>
 	return ciphertextBlock;
 }
 
+void ANGELITA128::permuteBlock(unsigned char* block, const std::array<std::array<std::uint64_t, 2>, 4096>& table) const {
+	//P-Box a block in place using the precomputed tables, same result as jn4_1(usePBox(sp1_4(block)))
+	std::uint64_t low = 0;
+	std::uint64_t high = 0;
+	for (unsigned int n = 0; n < 16; n++) {
+		const std::array<std::uint64_t, 2>& entry = table[n * 256 + block[n]];
+		low ^= entry[0];
+		high ^= entry[1];
+	}
+	std::memcpy(block, &low, 8);
+	std::memcpy(block + 8, &high, 8);
+}
+
+void ANGELITA128::encryptLanes(unsigned char* blocks, unsigned int lanes) const {
+	//Encryption routine over up to 16 independent blocks, stored one after the other
+	//Each step runs across all the lanes before the next, so the S-Box lookups
+	//of different blocks don't wait on each other and the XORs vectorize
+	for (unsigned int cycles = 1; cycles <= 16; cycles++) {
+		if (cycles % 2 == 0) {
+			for (unsigned int lane = 0; lane < lanes; lane++) {
+				this->permuteBlock(blocks + lane * 16, this->PboxTable);
+			}
+		}
+		unsigned int KS_Counter = (cycles - 1) * 16;
+		for (unsigned int i = 0; i < 16; i++, KS_Counter++) {
+			unsigned char xor1 = this->KS_XOR1[KS_Counter];
+			unsigned char xor2 = this->KS_XOR2[KS_Counter];
+			for (unsigned int lane = 0; lane < lanes; lane++) {
+				unsigned char& byte = blocks[lane * 16 + i];
+				byte = this->Sbox[byte ^ xor1] ^ xor2;
+			}
+		}
+	}
+}
+
+void ANGELITA128::decryptLanes(unsigned char* blocks, unsigned int lanes) const {
+	//Decryption routine over up to 16 independent blocks, the reverse of encryptLanes
+	for (unsigned int cycles = 16; cycles > 0; cycles--) {
+		unsigned int KS_Counter = (cycles - 1) * 16;
+		for (unsigned int i = 0; i < 16; i++, KS_Counter++) {
+			unsigned char xor1 = this->KS_XOR1[KS_Counter];
+			unsigned char xor2 = this->KS_XOR2[KS_Counter];
+			for (unsigned int lane = 0; lane < lanes; lane++) {
+				unsigned char& byte = blocks[lane * 16 + i];
+				byte = this->revSbox[byte ^ xor2] ^ xor1;
+			}
+		}
+		if (cycles % 2 == 0) {
+			for (unsigned int lane = 0; lane < lanes; lane++) {
+				this->permuteBlock(blocks + lane * 16, this->revPboxTable);
+			}
+		}
+	}
+}
+
 std::array<unsigned char, 16> ANGELITA128::GLORIA() {
 	//GLORIA: Generator of Lovely Random Intersperse Automator
 	//First generate 2048 prng bytes
@@ -585,7 +667,10 @@ std::array<unsigned char, 16> ANGELITA128::GLORIA() {
 ///////////////////
 
 ANGELITA128::ANGELITA128() {
-
+	//Start from the tuning profile in use, the built-in defaults unless one was calibrated or loaded
+	ANGELITA128_Profile profile = ANGELITA128::profile();
+	this->laneCount = profile.laneCount;
+	this->chunkSize = profile.chunkSize;
 }
 
 void ANGELITA128::genKey() {
@@ -596,8 +681,12 @@ void ANGELITA128::genKey() {
 	this->genKS();
 	this->genSBox();
 	this->genPBox();
+	this->genRevSbox();
+	this->genRevPbox();
+	this->genPboxTables();
+	this->genAuthTables();
 	this->keySet = 1;
-	this->reverseSet = 0;
+	this->reverseSet = 1;
 }
 
 void ANGELITA128::setKeyS(std::string keyString) {
@@ -617,8 +706,12 @@ void ANGELITA128::setKeyS(std::string keyString) {
 	this->genKS();
 	this->genSBox();
 	this->genPBox();
+	this->genRevSbox();
+	this->genRevPbox();
+	this->genPboxTables();
+	this->genAuthTables();
 	this->keySet = 1;
-	this->reverseSet = 0;
+	this->reverseSet = 1;
 }
 
 void ANGELITA128::setKeyH(std::string hexString) {
@@ -642,26 +735,35 @@ void ANGELITA128::setKeyH(std::string hexString) {
 	this->genKS();
 	this->genSBox();
 	this->genPBox();
+	this->genRevSbox();
+	this->genRevPbox();
+	this->genPboxTables();
+	this->genAuthTables();
 	this->keySet = 1;
-	this->reverseSet = 0;
+	this->reverseSet = 1;
 }
 
 void ANGELITA128::showKey() {
 	//Output the key as a 32 digit hexadecimal string to the console
-	std::cout << "Key: ";
-	//Store old cout state:
-	std::ios oldState(nullptr);
-	oldState.copyfmt(std::cout);
+	std::cout << "Key: " << this->keyHex() << "\n";
+}
 
-	//Output hexadecimal digits to console:
-	std::cout << std::hex << std::setfill('0');
+std::string ANGELITA128::keyHex() const {
+	//The key as a 32 digit hexadecimal string, as setKeyH takes it
+	std::ostringstream hexStream;
+	hexStream << std::hex << std::setfill('0');
 	for (unsigned int i = 0; i < 16; i++) {
-		std::cout << std::setw(2) << (int)this->initialKey0[i];
+		hexStream << std::setw(2) << (int)this->initialKey0[i];
 	}
-	std::cout << "\n";
+	return hexStream.str();
+}
+
+bool ANGELITA128::hasKey() const {
+	return this->keySet;
+}
 
-	//Restore old cout state
-	std::cout.copyfmt(oldState);
+std::array<unsigned char, 16> ANGELITA128::newIV() {
+	return this->GLORIA();
 }
 
 void ANGELITA128::encrypt(std::string file, std::string mode) {
@@ -675,127 +777,222 @@ void ANGELITA128::encrypt(std::string file, std::string mode) {
 		throw ANGELITA128_Exception("ANGELITA128: Invalid encrypt mode, must be \"ecb\" or \"cbc\".");
 	}
 
-	//Input file as chars
-	std::streampos size;
-	std::ifstream fileHandle(file, std::ios::in | std::ios::binary | std::ios::ate);
-	size = fileHandle.tellg();
-	std::vector <char> inputFile0;
-	inputFile0.resize(size);
-	if (fileHandle.is_open()) {
-		fileHandle.seekg(0, std::ios::beg);
-		fileHandle.read(&inputFile0[0], size);
-		fileHandle.close();
+	//The IV is made here since GLORIA borrows the S-Box and P-Box while it runs
+	std::array<unsigned char, 16> IV = {};
+	if (mode == "cbc") {
+		IV = this->GLORIA();
 	}
-	else {
+	this->encryptFile(file, mode, IV);
+}
+
+void ANGELITA128::encryptFile(std::string file, std::string mode, std::array<unsigned char, 16> IV) const {
+	//Encrypt the file with the already checked key and mode, one chunk at a time
+	//The output goes straight to the ".ANGELITA128" file, and the original is removed once it is complete
+	//For cbc mode the IV is supplied by the caller, and written ahead of the blocks
+	int inputFd = open(file.c_str(), O_RDONLY);
+	if (inputFd < 0) {
 		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and encrypt.");
 	}
+	struct stat inputStat;
+	fstat(inputFd, &inputStat);
+	std::string newFileName = file + ".ANGELITA128";
+	int outputFd = open(newFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+	if (outputFd < 0) {
+		close(inputFd);
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after encrypt.");
+	}
 
-	//Convert input to unsigned chars
-	std::vector <unsigned char> inputFile;
-	inputFile.resize(size);
-	for (unsigned int i = 0; i < inputFile0.size(); i++) {
-		inputFile[i] = (reinterpret_cast<unsigned char&>(inputFile0[i]));
+	bool cbc = mode == "cbc";
+	std::array<unsigned char, 16> chainBlock = IV;
+	ANGELITA128_ChunkTransform transform = this->encryptTransform(cbc, chainBlock);
+
+	try {
+		std::uint64_t outputOffset = 0;
+		if (cbc) {
+			ANGELITA128_IO::writeAt(outputFd, IV.data(), 16, 0);
+			outputOffset = 16;
+		}
+		ANGELITA128_IO::create(this->ioBackend)->run(inputFd, 0, outputFd, outputOffset, this->chunkSize, transform);
+	}
+	catch (...) {
+		close(inputFd);
+		close(outputFd);
+		unlink(newFileName.c_str());
+		throw;
+	}
+	close(inputFd);
+	if (close(outputFd) != 0) {
+		unlink(newFileName.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not write file after encrypt.");
 	}
 
-	//Use padding to make 16n blocks even
-	unsigned int paddingSize = 16 - (inputFile.size() % 16);
-	for (unsigned int i = 0; i < paddingSize; i++) {
-		inputFile.push_back((unsigned char)paddingSize);
+	//Only the encrypted file is left, with the new extension
+	if (unlink(file.c_str()) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not remove the original file after encrypt.");
 	}
+}
 
-	//Resize output vector
-	std::vector <unsigned char> outputFile1;
-	if (mode == "ecb") {
-		outputFile1.resize(size + (std::streampos)paddingSize);
+void ANGELITA128::decrypt(std::string file, std::string mode) {
+	//Decrypt the file using the set key and either "ecb" or "cbc" mode
+	//ecb: Electronic Code Book mode
+	//cbc: Cipher Block Chaining mode
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
 	}
-	else if (mode == "cbc") {
-		outputFile1.resize(size + (std::streampos)paddingSize + (std::streampos)16);
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid decrypt mode, must be \"ecb\" or \"cbc\".");
 	}
 
-	//Encrypt either ecb or cbc mode
-	unsigned blockCount = inputFile.size() / 16;
-	if (mode == "ecb") {
-		std::array<unsigned char, 16> plaintextBlock;
-		unsigned int blockIndex = 0;
-		unsigned int blockIndex2 = 0;
-		for (unsigned int blockNumber = 0; blockNumber < blockCount; blockNumber++) {
-			for (unsigned int i = 0; i < 16; i++, blockIndex++) {
-				plaintextBlock[i] = inputFile[blockIndex];
-			}
-			plaintextBlock = this->encrypt(plaintextBlock);
-			for (unsigned int i = 0; i < 16; i++, blockIndex2++) {
-				outputFile1[blockIndex2] = plaintextBlock[i];
-			}
-		}
+	//If reverse S-Box and P-Box are not set, set them
+	if (!this->reverseSet) {
+		this->genRevSbox();
+		this->genRevPbox();
+		this->reverseSet = 1;
 	}
-	else if (mode == "cbc") {
-		std::array<unsigned char, 16> plaintextBlock2 = this->GLORIA();
-		std::array<unsigned char, 16> plaintextBlock1;
-		unsigned int blockIndex = 0;
-		unsigned int blockIndex2 = 0;
-		for (unsigned int blockNumber = 1; blockNumber <= blockCount; blockNumber++) {
-			for (unsigned int i = 0; i < 16; i++, blockIndex++) {
-				plaintextBlock1[i] = inputFile[blockIndex];
-			}
-			for (unsigned int i = 0; i < 16; i++) {
-				plaintextBlock1[i] ^= plaintextBlock2[i];
-			}
 
-			for (unsigned int i = 0; i < 16; i++, blockIndex2++) {
-				outputFile1[blockIndex2] = plaintextBlock2[i];
-			}
-			plaintextBlock2 = this->encrypt(plaintextBlock1);
+	this->decryptFile(file, mode);
+}
 
-		}
-		for (unsigned int i = 0; i < 16; i++, blockIndex2++) {
-			outputFile1[blockIndex2] = plaintextBlock2[i];
-		}
+void ANGELITA128::decryptFile(std::string file, std::string mode) const {
+	//Decrypt the file with the already checked key and mode, one chunk at a time
+	//The output goes to the file name without the "ANGELITA128" extension, and the encrypted file is removed once it is complete
+	int inputFd = open(file.c_str(), O_RDONLY);
+	if (inputFd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and decrypt.");
+	}
+	struct stat inputStat;
+	fstat(inputFd, &inputStat);
+	bool cbc = mode == "cbc";
+	if (inputStat.st_size == 0 || inputStat.st_size % 16 != 0 || (cbc && inputStat.st_size < 32)) {
+		close(inputFd);
+		throw ANGELITA128_Exception("ANGELITA128: File size is not valid for decrypt, file is not encrypted in this mode.");
+	}
 
+	//Remove the "ANGELITA128" extension from the file name
+	//Without the extension the result replaces the file itself once it is complete
+	std::string newFileName = std::regex_replace(file, std::regex("(\\.ANGELITA128)$"), "");
+	std::string outputName = newFileName;
+	if (newFileName == file) {
+		outputName = file + ".ANGELITA128_decrypt";
 	}
+	int outputFd = open(outputName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+	if (outputFd < 0) {
+		close(inputFd);
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after decrypt.");
+	}
+
+	std::array<unsigned char, 16> chainBlock;
+	ANGELITA128_ChunkTransform transform = this->decryptTransform(cbc, chainBlock);
 
-	//Make char output for file write
-	std::vector <char> outputFile2;
-	std::streampos size2;
-	if (mode == "ecb") {
-		size2 = size + (std::streampos)paddingSize;
+	try {
+		std::uint64_t inputOffset = 0;
+		if (cbc) {
+			ANGELITA128_IO::readAt(inputFd, chainBlock.data(), 16, 0);
+			inputOffset = 16;
+		}
+		ANGELITA128_IO::create(this->ioBackend)->run(inputFd, inputOffset, outputFd, 0, this->chunkSize, transform);
+	}
+	catch (...) {
+		close(inputFd);
+		close(outputFd);
+		unlink(outputName.c_str());
+		throw;
 	}
-	else if (mode == "cbc") {
-		size2 = size + (std::streampos)paddingSize + (std::streampos)16;
+	close(inputFd);
+	if (close(outputFd) != 0) {
+		unlink(outputName.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not write file after decrypt.");
 	}
-	outputFile2.resize(size2);
 
-	//Convert unsigned char to char
-	for (unsigned int i = 0; i < outputFile1.size(); i++) {
-		outputFile2[i] = (reinterpret_cast<char&>(outputFile1[i]));
+	if (outputName != newFileName) {
+		if (std::rename(outputName.c_str(), newFileName.c_str()) != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not rename file after decrypt.");
+		}
+	}
+	else if (unlink(file.c_str()) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not remove the encrypted file after decrypt.");
 	}
+}
 
-	//Output the encrypted file bytes
-	std::ofstream file2(file, std::ios::out | std::ios::binary);
-	if (file2.is_open()) {
-		file2.write(&outputFile2[0], size2);
-		file2.close();
+ANGELITA128_ChunkTransform ANGELITA128::encryptTransform(bool cbc, std::array<unsigned char, 16>& chainBlock) const {
+	//The chunk transform for encrypting, chainBlock is the IV for cbc and must outlive the transform
+	return [this, cbc, &chainBlock](unsigned char* buffer, size_t length, bool lastChunk) {
+		//Use padding to make 16n blocks even
+		if (lastChunk) {
+			unsigned int paddingSize = 16 - (length % 16);
+			std::memset(buffer + length, paddingSize, paddingSize);
+			length += paddingSize;
+		}
+		if (cbc) {
+			this->encryptCBC(buffer, buffer, length / 16, chainBlock);
+		}
+		else {
+			this->encryptECB(buffer, buffer, length / 16);
+		}
+		return length;
+	};
+}
+
+ANGELITA128_ChunkTransform ANGELITA128::decryptTransform(bool cbc, std::array<unsigned char, 16>& chainBlock) const {
+	//The chunk transform for decrypting, chainBlock is the IV for cbc and must outlive the transform
+	return [this, cbc, &chainBlock](unsigned char* buffer, size_t length, bool lastChunk) {
+		//A file's size is checked before starting, a pipe's only shows at the end
+		if (lastChunk && (length == 0 || length % 16 != 0)) {
+			throw ANGELITA128_Exception("ANGELITA128: Input length is not valid for decrypt, input is not encrypted in this mode.");
+		}
+		if (cbc) {
+			this->decryptCBC(buffer, buffer, length / 16, chainBlock);
+		}
+		else {
+			this->decryptECB(buffer, buffer, length / 16);
+		}
+		//Get the padding size and remove the padding from decrypted output
+		if (lastChunk) {
+			unsigned int paddingSize = buffer[length - 1];
+			if (paddingSize == 0 || paddingSize > 16) {
+				throw ANGELITA128_Exception("ANGELITA128: Invalid padding after decrypt, wrong key or mode.");
+			}
+			length -= paddingSize;
+		}
+		return length;
+	};
+}
+
+std::uint64_t ANGELITA128::currentOffset(int fd) {
+	//Where a file descriptor is positioned, pipes have no position and are left as they are
+	off_t offset = lseek(fd, 0, SEEK_CUR);
+	return offset < 0 ? 0 : offset;
+}
+
+std::uint64_t ANGELITA128::encryptStream(int inputFd, int outputFd, std::string mode) {
+	//Encrypt everything left on inputFd to outputFd using the set key and either "ecb" or "cbc" mode
+	//Nothing is held beyond the chunk buffers, so any length can go through
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to encrypt.");
 	}
-	else {
-		throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after encrypt.");
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid encrypt mode, must be \"ecb\" or \"cbc\".");
 	}
 
-	//Rename the encrypted file with the new extension
-	std::string newFileName = file + ".ANGELITA128";
-	std::string sysOut = "mv " + file + " " + newFileName;
-	char* sysOutc = new char[150];
-	unsigned int i = 0;
-	for (; i < sysOut.length(); i++) {
-		sysOutc[i] = sysOut[i];
+	bool cbc = mode == "cbc";
+	std::array<unsigned char, 16> chainBlock;
+	if (cbc) {
+		chainBlock = this->GLORIA();
+		ANGELITA128_IO::writeAll(outputFd, chainBlock.data(), 16);
 	}
-	sysOutc[i] = '\0';
-	system(sysOutc);
-	delete[] sysOutc;
+	std::uint64_t bytes = 0;
+	ANGELITA128_ChunkTransform encryptChunk = this->encryptTransform(cbc, chainBlock);
+	ANGELITA128_ChunkTransform transform = [&bytes, &encryptChunk](unsigned char* buffer, size_t length, bool lastChunk) {
+		bytes += length;
+		return encryptChunk(buffer, length, lastChunk);
+	};
+	ANGELITA128_IO::create(this->ioBackend)->run(inputFd, currentOffset(inputFd), outputFd, currentOffset(outputFd), this->chunkSize, transform);
+	return bytes;
 }
 
-void ANGELITA128::decrypt(std::string file, std::string mode) {
-	//Decrypt the file using the set key and either "ecb" or "cbc" mode
-	//ecb: Electronic Code Book mode
-	//cbc: Cipher Block Chaining mode
+std::uint64_t ANGELITA128::decryptStream(int inputFd, int outputFd, std::string mode) {
+	//Decrypt everything left on inputFd to outputFd using the set key and either "ecb" or "cbc" mode
+	//The padding is only checked at the end of the input, so on a bad key or mode some output is already written
 	if (!this->keySet) {
 		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
 	}
@@ -803,121 +1000,212 @@ void ANGELITA128::decrypt(std::string file, std::string mode) {
 		throw ANGELITA128_Exception("ANGELITA128: Invalid decrypt mode, must be \"ecb\" or \"cbc\".");
 	}
 
-	//If reverse S-Box and P-Box are not set, set them
-	if (!this->reverseSet) {
-		this->genRevSbox();
-		this->genRevPbox();
-		this->reverseSet = 1;
-	}
+	bool cbc = mode == "cbc";
+	std::array<unsigned char, 16> chainBlock;
+	std::uint64_t bytes = 0;
+	if (cbc) {
+		if (ANGELITA128_IO::readAll(inputFd, chainBlock.data(), 16) != 16) {
+			throw ANGELITA128_Exception("ANGELITA128: Input length is not valid for decrypt, input is not encrypted in this mode.");
+		}
+		bytes = 16;
+	}
+	ANGELITA128_ChunkTransform decryptChunk = this->decryptTransform(cbc, chainBlock);
+	ANGELITA128_ChunkTransform transform = [&bytes, &decryptChunk](unsigned char* buffer, size_t length, bool lastChunk) {
+		bytes += length;
+		return decryptChunk(buffer, length, lastChunk);
+	};
+	ANGELITA128_IO::create(this->ioBackend)->run(inputFd, currentOffset(inputFd), outputFd, currentOffset(outputFd), this->chunkSize, transform);
+	return bytes;
+}
 
-	//Input the file to decrypt
-	std::streampos size;
-	std::ifstream fileHandle(file, std::ios::in | std::ios::binary | std::ios::ate);
-	size = fileHandle.tellg();
-	std::vector <char> inputFile0;
-	inputFile0.resize(size);
-	if (fileHandle.is_open()) {
-		fileHandle.seekg(0, std::ios::beg);
-		fileHandle.read(&inputFile0[0], size);
-		fileHandle.close();
-	}
-	else {
-		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and encrypt.");
+void ANGELITA128::encryptECB(const unsigned char* input, unsigned char* output, size_t blockCount) const {
+	//Encrypt whole blocks in Electronic Code Book mode, input and output may be the same buffer
+	//The blocks are independent, so they go through the lane kernel a group at a time
+	unsigned char laneBlocks[256];
+	while (blockCount > 0) {
+		unsigned int lanes = blockCount < this->laneCount ? blockCount : this->laneCount;
+		std::memcpy(laneBlocks, input, lanes * 16);
+		this->encryptLanes(laneBlocks, lanes);
+		std::memcpy(output, laneBlocks, lanes * 16);
+		input += lanes * 16;
+		output += lanes * 16;
+		blockCount -= lanes;
 	}
+}
 
-	//Convert char to unsigned char
-	std::vector <unsigned char> inputFile;
-	inputFile.resize(size);
-	std::vector <unsigned char> outputFile1;
-	if (mode == "ecb") {
-		outputFile1.resize(size);
+void ANGELITA128::decryptECB(const unsigned char* input, unsigned char* output, size_t blockCount) const {
+	//Decrypt whole blocks in Electronic Code Book mode, input and output may be the same buffer
+	unsigned char laneBlocks[256];
+	while (blockCount > 0) {
+		unsigned int lanes = blockCount < this->laneCount ? blockCount : this->laneCount;
+		std::memcpy(laneBlocks, input, lanes * 16);
+		this->decryptLanes(laneBlocks, lanes);
+		std::memcpy(output, laneBlocks, lanes * 16);
+		input += lanes * 16;
+		output += lanes * 16;
+		blockCount -= lanes;
 	}
-	else if (mode == "cbc") {
-		outputFile1.resize(size - (std::streampos)16);
-	}
-	for (unsigned int i = 0; i < inputFile0.size(); i++) {
-		inputFile[i] = (reinterpret_cast<unsigned char&>(inputFile0[i]));
+}
+
+void ANGELITA128::encryptCBC(const unsigned char* input, unsigned char* output, size_t blockCount, std::array<unsigned char, 16>& chainBlock) const {
+	//Encrypt whole blocks in Cipher Block Chaining mode
+	//chainBlock starts as the IV and is left as the last ciphertext block, so the next chunk carries on from it
+	//Each block needs the one before, so only one lane is used; see encryptCBCMulti for many streams
+	for (size_t blockNumber = 0; blockNumber < blockCount; blockNumber++, input += 16, output += 16) {
+		for (unsigned int i = 0; i < 16; i++) {
+			chainBlock[i] ^= input[i];
+		}
+		this->encryptLanes(chainBlock.data(), 1);
+		std::memcpy(output, chainBlock.data(), 16);
 	}
+}
 
-	//Decrypt in either ecb or cbc mode
-	unsigned int blockCount = inputFile.size() / 16;
-	if (mode == "ecb") {
-		std::array<unsigned char, 16> ciphertextBlock;
-		unsigned int blockIndex = 0;
-		unsigned int blockIndex2 = 0;
-		for (unsigned int blockNumber = 0; blockNumber < blockCount; blockNumber++) {
-			for (unsigned int i = 0; i < 16; i++, blockIndex++) {
-				ciphertextBlock[i] = inputFile[blockIndex];
-			}
-			ciphertextBlock = this->decrypt(ciphertextBlock);
-			for (unsigned int i = 0; i < 16; i++, blockIndex2++) {
-				outputFile1[blockIndex2] = ciphertextBlock[i];
-			}
+void ANGELITA128::decryptCBC(const unsigned char* input, unsigned char* output, size_t blockCount, std::array<unsigned char, 16>& chainBlock) const {
+	//Decrypt whole blocks in Cipher Block Chaining mode, input and output may be the same buffer
+	//chainBlock starts as the IV and is left as the last ciphertext block, so the next chunk carries on from it
+	//Every ciphertext block is already known, so the decryptions go through the lane kernel together
+	unsigned char laneBlocks[256];
+	unsigned char ciphertextBlocks[272];
+	while (blockCount > 0) {
+		unsigned int lanes = blockCount < this->laneCount ? blockCount : this->laneCount;
+		std::memcpy(ciphertextBlocks, chainBlock.data(), 16);
+		std::memcpy(ciphertextBlocks + 16, input, lanes * 16);
+		std::memcpy(laneBlocks, input, lanes * 16);
+		this->decryptLanes(laneBlocks, lanes);
+		for (unsigned int i = 0; i < lanes * 16; i++) {
+			output[i] = laneBlocks[i] ^ ciphertextBlocks[i];
 		}
+		std::memcpy(chainBlock.data(), ciphertextBlocks + lanes * 16, 16);
+		input += lanes * 16;
+		output += lanes * 16;
+		blockCount -= lanes;
 	}
-	else if (mode == "cbc") {
-		std::array<unsigned char, 16> ciphertextBlock1;
-		std::array<unsigned char, 16> ciphertextBlock2;
-		int blockIndex = inputFile.size() - 1;
-		int blockIndex2 = outputFile1.size() - 1;
-		for (unsigned int blockNumber = blockCount; blockNumber > 1; blockNumber--) {
-			if (blockNumber == blockCount) {
-				for (int i = 15; i >= 0; i--, blockIndex--) {
-					ciphertextBlock1[i] = inputFile[blockIndex];
-				}
-			}
-			ciphertextBlock2 = this->decrypt(ciphertextBlock1);
-			for (int i = 15; i >= 0; i--, blockIndex--) {
-				ciphertextBlock1[i] = inputFile[blockIndex];
+}
+
+void ANGELITA128::encryptCBCMulti(std::vector<ANGELITA128_CBCJob>& jobs) const {
+	//Encrypt several independent CBC streams side by side
+	//One stream can't be spread over lanes, but block n of up to 16 different streams can,
+	//so each lane carries one job and is given the next job as soon as its job runs out
+	unsigned char laneBlocks[256];
+	size_t laneJob[16];
+	size_t laneBlock[16];
+	unsigned int activeLanes = 0;
+	size_t nextJob = 0;
+	for (;;) {
+		while (activeLanes < this->laneCount && nextJob < jobs.size()) {
+			if (jobs[nextJob].blockCount > 0) {
+				laneJob[activeLanes] = nextJob;
+				laneBlock[activeLanes] = 0;
+				activeLanes++;
 			}
-			for (int i = 0; i < 16; i++) {
-				ciphertextBlock2[i] ^= ciphertextBlock1[i];
+			nextJob++;
+		}
+		if (activeLanes == 0) {
+			break;
+		}
+
+		for (unsigned int lane = 0; lane < activeLanes; lane++) {
+			const ANGELITA128_CBCJob& job = jobs[laneJob[lane]];
+			const unsigned char* plaintextBlock = job.input + laneBlock[lane] * 16;
+			for (unsigned int i = 0; i < 16; i++) {
+				laneBlocks[lane * 16 + i] = plaintextBlock[i] ^ job.chainBlock[i];
 			}
-			for (int i = 15; i >= 0; i--, blockIndex2--) {
-				outputFile1[blockIndex2] = ciphertextBlock2[i];
+		}
+		this->encryptLanes(laneBlocks, activeLanes);
+		for (unsigned int lane = 0; lane < activeLanes;) {
+			ANGELITA128_CBCJob& job = jobs[laneJob[lane]];
+			std::memcpy(job.chainBlock.data(), laneBlocks + lane * 16, 16);
+			std::memcpy(job.output + laneBlock[lane] * 16, laneBlocks + lane * 16, 16);
+			laneBlock[lane]++;
+			if (laneBlock[lane] == job.blockCount) {
+				//Finished, the last lane takes its place
+				activeLanes--;
+				laneJob[lane] = laneJob[activeLanes];
+				laneBlock[lane] = laneBlock[activeLanes];
+				std::memcpy(laneBlocks + lane * 16, laneBlocks + activeLanes * 16, 16);
+				continue;
 			}
+			lane++;
 		}
 	}
+}
 
-	//Get the padding size and remove the padding from decrypted output
-	unsigned int paddingSize = outputFile1[outputFile1.size() - 1];
-	outputFile1.erase(outputFile1.end() - paddingSize, outputFile1.end());
-
-	//Get the adjusted size minus the padding or IV for cbc mode
-	std::streampos size2;
-	if (mode == "ecb") {
-		size2 = size - (std::streampos)paddingSize;
-	}
-	else if (mode == "cbc") {
-		size2 = size - (std::streampos)paddingSize - (std::streampos)16;
+void ANGELITA128::counterAdd(std::array<unsigned char, 16>& counterBlock, std::uint64_t count) {
+	//Add to a 128-bit big endian counter block
+	for (int i = 15; i >= 0 && count > 0; i--) {
+		std::uint64_t sum = counterBlock[i] + (count & 255);
+		counterBlock[i] = sum & 255;
+		count = (count >> 8) + (sum >> 8);
 	}
-	std::vector <char> outputFile2;
-	outputFile2.resize(size2);
+}
 
-	//Convert decrypted output in unsigned chars into chars
-	for (unsigned int i = 0; i < outputFile1.size(); i++) {
-		outputFile2[i] = (reinterpret_cast<char&>(outputFile1[i]));
+void ANGELITA128::encryptCTR(const unsigned char* input, unsigned char* output, size_t length, std::array<unsigned char, 16> counterBlock) const {
+	//Encrypt in Counter mode: XOR with the encrypted counter blocks, any length, input and output may be the same buffer
+	//counterBlock is the counter for the first block, the keystream blocks go through the lanes together
+	unsigned char laneBlocks[256];
+	while (length > 0) {
+		size_t blocks = (length + 15) / 16;
+		unsigned int lanes = blocks < this->laneCount ? blocks : this->laneCount;
+		for (unsigned int lane = 0; lane < lanes; lane++) {
+			std::memcpy(laneBlocks + lane * 16, counterBlock.data(), 16);
+			counterAdd(counterBlock, 1);
+		}
+		this->encryptLanes(laneBlocks, lanes);
+		size_t bytes = length < lanes * 16 ? length : lanes * 16;
+		for (size_t i = 0; i < bytes; i++) {
+			output[i] = input[i] ^ laneBlocks[i];
+		}
+		input += bytes;
+		output += bytes;
+		length -= bytes;
 	}
+}
 
-	//Output decrypted file
-	std::ofstream file2(file, std::ios::out | std::ios::binary);
-	if (file2.is_open()) {
-		file2.write(&outputFile2[0], size2);
-		file2.close();
+void ANGELITA128::decryptCTR(const unsigned char* input, unsigned char* output, size_t length, std::array<unsigned char, 16> counterBlock) const {
+	//Decrypt in Counter mode, the same keystream as encryption
+	this->encryptCTR(input, output, length, counterBlock);
+}
+
+unsigned int ANGELITA128::resolveThreadCount(unsigned int threadCount) {
+	//0 means the scheduler's thread count, one thread per core unless set
+	if (threadCount == 0) {
+		threadCount = ANGELITA128_Scheduler::shared().threadCount();
 	}
-	else {
-		throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after decrypt.");
+	return threadCount;
+}
+
+void ANGELITA128::parallelFor(size_t count, unsigned int threadCount, std::function<void(size_t)> work) {
+	//Run work(0) to work(count - 1) over up to threadCount threads, including the calling one, on the shared scheduler
+	//The first exception thrown is passed on once all the threads are done
+	ANGELITA128_Scheduler::shared().forEach(count, resolveThreadCount(threadCount), work);
+}
+
+void ANGELITA128::setThreadCount(unsigned int threadCount) {
+	ANGELITA128_Scheduler::shared().setThreadCount(threadCount);
+}
+
+void ANGELITA128::setThreadAffinity(std::vector<unsigned int> cores) {
+	ANGELITA128_Scheduler::shared().setAffinity(cores);
+}
+
+void ANGELITA128::setLaneCount(unsigned int lanes) {
+	//Set how many blocks the lane kernel works on side by side
+	if (lanes < 1 || lanes > 16) {
+		throw ANGELITA128_Exception("ANGELITA128: Lane count must be from 1 to 16.");
 	}
+	this->laneCount = lanes;
+}
 
-	//Remove the "ANGELITA128" extension from the file name
-	std::string newFileName = std::regex_replace(file, std::regex("(\\.ANGELITA128)$"), "");
-	std::string sysOut = "mv " + file + " " + newFileName;
-	char* sysOutc = new char[150];
-	unsigned int i = 0;
-	for (; i < sysOut.length(); i++) {
-		sysOutc[i] = sysOut[i];
-	}
-	sysOutc[i] = '\0';
-	system(sysOutc);
-	delete[] sysOutc;
+void ANGELITA128::setIOBackend(std::string backend) {
+	//Choose how the file interface reads and writes: "auto", "blocking" or "io_uring"
+	ANGELITA128_IO::create(backend);
+	this->ioBackend = backend;
+}
+
+void ANGELITA128::setChunkSize(size_t bytes) {
+	//Set how many bytes the file interface reads, encrypts and writes at a time
+	if (bytes < 16 || bytes % 16 != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Chunk size must be a multiple of 16 bytes.");
+	}
+	this->chunkSize = bytes;
 }
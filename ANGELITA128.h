@@ -68,8 +68,46 @@
 #define ANGELITA128_H
 
 #include "ANGELITA128_Exception.h"
+#include "ANGELITA128_Batch.h"
+#include "ANGELITA128_IO.h"
+#include "ANGELITA128_Container.h"
+#include "ANGELITA128_Archive.h"
+#include "ANGELITA128_Async.h"
+#include "ANGELITA128_Profile.h"
 #include <array>
 #include <vector>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+//ECB_CTS and CBC_CTS steal ciphertext from the last whole block instead of padding, so they keep the length
+//but need at least 16 bytes; with whole blocks they are the same as ECB and CBC without the padding block
+enum class ANGELITA128_Mode {
+	ECB,
+	CBC,
+	CTR,
+	ECB_CTS,
+	CBC_CTS
+};
+
+enum class ANGELITA128_Status {
+	OK,
+	KEY_NOT_SET,
+	BUFFER_TOO_SMALL,
+	BAD_LENGTH,
+	BAD_PADDING,
+	ZERO_IV
+};
+
+struct ANGELITA128_CBCJob {
+	//One independent CBC stream for encryptCBCMulti
+	//chainBlock starts as the IV and is left as the last ciphertext block
+	const unsigned char* input = nullptr;
+	unsigned char* output = nullptr;
+	size_t blockCount = 0;
+	std::array<unsigned char, 16> chainBlock = {};
+};
 
 class ANGELITA128 {
 private:
@@ -86,13 +124,22 @@ private:
 	std::array<unsigned char, 2560> KS_PBOX_BITS;
 	std::array<unsigned char, 256> KS_XOR1;
 	std::array<unsigned char, 256> KS_XOR2;
+	std::array<std::array<std::uint64_t, 2>, 4096> PboxTable;
+	std::array<std::array<std::uint64_t, 2>, 4096> revPboxTable;
+	//Offsets for the authenticated mode, L* = E(0), L$ = 2 L*, L[0] = 2 L$, L[i + 1] = 2 L[i]
+	std::array<unsigned char, 16> authLStar;
+	std::array<unsigned char, 16> authLDollar;
+	std::array<std::array<unsigned char, 16>, 64> authL;
 	bool keySet = 0;
 	bool reverseSet = 0;
+	size_t chunkSize = 1048576;
+	unsigned int laneCount = 16;
+	std::string ioBackend = "auto";
 
 	std::array<unsigned char, 9728> sp1_8(std::array<unsigned char, 1216> bytes);
 	std::array<unsigned char, 2560> sp1_8(std::array<unsigned char, 320> bytes);
-	std::array<unsigned char, 64> sp1_4(std::array<unsigned char, 16> bytes);
-	std::array<unsigned char, 16> jn4_1(std::array<unsigned char, 64> twoBits);
+	std::array<unsigned char, 64> sp1_4(std::array<unsigned char, 16> bytes) const;
+	std::array<unsigned char, 16> jn4_1(std::array<unsigned char, 64> twoBits) const;
 	std::array<unsigned char, 256> rotateBytes(std::array<unsigned char, 256> bytes);
 	std::array<unsigned char, 16> xorBytes(std::array<unsigned char, 16> bytes, unsigned char byte, unsigned int skippedIndex);
 
@@ -102,21 +149,60 @@ private:
 	void genPBox();
 	void genRevSbox();
 	void genRevPbox();
+	void genPboxTables();
+	void genAuthTables();
 
 	std::array<unsigned char, 2048> ANGELITA128_KISS();
 	std::array<unsigned char, 2048> ANGELITA128_KISS2();
 	void genKS();
 
-	unsigned char useSBox(unsigned char blockByte);
-	std::array<unsigned char, 64> usePBox(std::array<unsigned char, 64> block2bits);
-	unsigned char useRevSBox(unsigned char blockByte);
-	std::array<unsigned char, 64> useRevPBox(std::array<unsigned char, 64> block2bits);
+	unsigned char useSBox(unsigned char blockByte) const;
+	std::array<unsigned char, 64> usePBox(std::array<unsigned char, 64> block2bits) const;
+	unsigned char useRevSBox(unsigned char blockByte) const;
+	std::array<unsigned char, 64> useRevPBox(std::array<unsigned char, 64> block2bits) const;
 
-	std::array<unsigned char, 16> encrypt(std::array<unsigned char, 16> plaintextBlock);
-	std::array<unsigned char, 16> decrypt(std::array<unsigned char, 16> ciphertextBlock);
+	std::array<unsigned char, 16> encrypt(std::array<unsigned char, 16> plaintextBlock) const;
+	std::array<unsigned char, 16> decrypt(std::array<unsigned char, 16> ciphertextBlock) const;
+
+	//Lane kernels, the same rounds as encrypt()/decrypt() run across up to 16 independent blocks
+	void permuteBlock(unsigned char* block, const std::array<std::array<std::uint64_t, 2>, 4096>& table) const;
+	void encryptLanes(unsigned char* blocks, unsigned int lanes) const;
+	void decryptLanes(unsigned char* blocks, unsigned int lanes) const;
+	static void counterAdd(std::array<unsigned char, 16>& counterBlock, std::uint64_t count);
+	void authBlocks(const unsigned char* input, unsigned char* output, size_t firstBlock, size_t blockCount, size_t hashedBlocks, std::array<unsigned char, 16> counterBlock, bool encrypting, std::array<unsigned char, 16>& sum) const;
+	void decryptBlocks(unsigned char* blocks, size_t blockCount, bool cbc, std::array<unsigned char, 16>& chainBlock, unsigned int threadCount) const;
+	void encryptBlocks(unsigned char* blocks, size_t blockCount, bool cbc, std::array<unsigned char, 16>& chainBlock, unsigned int threadCount) const;
+	void encryptStealing(unsigned char* data, size_t length, bool cbc, std::array<unsigned char, 16> chainBlock) const;
+	void decryptStealing(unsigned char* data, size_t length, bool cbc, std::array<unsigned char, 16> chainBlock) const;
+	void sectorBlocks(unsigned char* sector, size_t sectorSize, std::uint64_t sectorNumber, const ANGELITA128& tweakCipher, bool encrypting) const;
+	void checkSectorKeys(size_t sectorSize, const ANGELITA128& tweakCipher) const;
+	std::array<unsigned char, 16> authStart(const std::array<unsigned char, 16>& nonce) const;
+	void authTag(const unsigned char* ciphertext, size_t length, const std::array<unsigned char, 16>& startBlock, std::array<unsigned char, 16>& sum) const;
+	void archiveCTR(unsigned char* data, size_t length, std::uint64_t dataOffset, const std::array<unsigned char, 16>& IV, unsigned int threadCount) const;
+	std::vector<ANGELITA128_ArchiveEntry> readArchiveTable(int fd, const ANGELITA128_ArchiveHeader& header) const;
+	void hashLeaves(const unsigned char* data, std::uint64_t firstLeaf, size_t leafCount, std::array<unsigned char, 16>* hashes) const;
+	std::array<unsigned char, 16> hashLastLeaf(const unsigned char* data, size_t length, std::uint64_t leaf) const;
+	std::array<unsigned char, 16> hashTree(std::vector<std::array<unsigned char, 16>> nodes, std::uint64_t totalLength) const;
+
+	ANGELITA128_Task<std::uint64_t> transformAsync(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, ANGELITA128_ChunkTransform transform, ANGELITA128_AsyncIO& io) const;
+	ANGELITA128_Task<void> encryptFileAsync(std::string file, bool cbc, std::array<unsigned char, 16> IV, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const;
+	ANGELITA128_Task<void> decryptFileAsync(std::string file, bool cbc, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const;
+	ANGELITA128_Task<std::uint64_t> streamAsync(int inputFd, int outputFd, bool cbc, bool encrypting, std::array<unsigned char, 16> IV, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const;
 
 	std::array<unsigned char, 16> GLORIA();
 
+	//File routines shared by the single file and batch interfaces
+	//These only read the keyed state, so several threads may run them on one object
+	void encryptFile(std::string file, std::string mode, std::array<unsigned char, 16> IV) const;
+	void decryptFile(std::string file, std::string mode) const;
+	ANGELITA128_ChunkTransform encryptTransform(bool cbc, std::array<unsigned char, 16>& chainBlock) const;
+	ANGELITA128_ChunkTransform decryptTransform(bool cbc, std::array<unsigned char, 16>& chainBlock) const;
+	static std::uint64_t currentOffset(int fd);
+	ANGELITA128_BatchReport runBatch(std::vector<std::string> files, std::string mode, bool encrypting, unsigned int threadCount);
+	static unsigned int resolveThreadCount(unsigned int threadCount);
+	static void parallelFor(size_t count, unsigned int threadCount, std::function<void(size_t)> work);
+	void encryptSmallFiles(std::vector<std::string>& files, std::vector<std::array<unsigned char, 16>>& IVs, std::vector<ANGELITA128_BatchResult>& results, std::vector<unsigned int> group) const;
+
 public:
 	ANGELITA128();
 
@@ -125,9 +211,130 @@ public:
 	void setKeyS(std::string keyString);
 	void setKeyH(std::string hexString);
 	void showKey();
+	std::string keyHex() const;
+	bool hasKey() const;
+	//A fresh IV from GLORIA, which borrows the S-Box and P-Box, so not while other threads use this object
+	std::array<unsigned char, 16> newIV();
 	void encrypt(std::string file, std::string mode);
 	void decrypt(std::string file, std::string mode);
 
+	//Batch interface
+	ANGELITA128_BatchReport encryptBatch(std::vector<std::string> files, std::string mode, unsigned int threadCount = 0);
+	ANGELITA128_BatchReport decryptBatch(std::vector<std::string> files, std::string mode, unsigned int threadCount = 0);
+	ANGELITA128_BatchReport encryptDirectory(std::string directory, std::string mode, unsigned int threadCount = 0);
+	ANGELITA128_BatchReport decryptDirectory(std::string directory, std::string mode, unsigned int threadCount = 0);
+
+	//Bulk interface, whole 16 byte blocks in memory
+	void encryptECB(const unsigned char* input, unsigned char* output, size_t blockCount) const;
+	void decryptECB(const unsigned char* input, unsigned char* output, size_t blockCount) const;
+	void encryptCBC(const unsigned char* input, unsigned char* output, size_t blockCount, std::array<unsigned char, 16>& chainBlock) const;
+	void decryptCBC(const unsigned char* input, unsigned char* output, size_t blockCount, std::array<unsigned char, 16>& chainBlock) const;
+	void encryptCBCMulti(std::vector<ANGELITA128_CBCJob>& jobs) const;
+	void encryptCTR(const unsigned char* input, unsigned char* output, size_t length, std::array<unsigned char, 16> counterBlock) const;
+	void decryptCTR(const unsigned char* input, unsigned char* output, size_t length, std::array<unsigned char, 16> counterBlock) const;
+	void setLaneCount(unsigned int lanes);
+
+	//Parallel settings, for the work-stealing scheduler every object in the process shares (ANGELITA128_Scheduler.h)
+	//setThreadCount sets what a thread count of 0 means in the calls that take one, 0 again for one per core
+	//setThreadAffinity pins the scheduler's threads to these CPUs in turn, an empty list lets them run anywhere
+	static void setThreadCount(unsigned int threadCount);
+	static void setThreadAffinity(std::vector<unsigned int> cores);
+
+	//Tuning profile (ANGELITA128_Profile.h), objects take the lane count and chunk size of the one in use when they are made
+	//calibrate times the candidates here, uses the winners and saves them to profileFile unless it is empty; it takes a few seconds
+	//loadProfile uses a saved one, false if it is missing or was made on a machine with a different core count
+	static ANGELITA128_Profile calibrate(std::string profileFile = "");
+	static bool loadProfile(std::string profileFile);
+	static void useProfile(const ANGELITA128_Profile& profile);
+	static ANGELITA128_Profile profile();
+
+	//File I/O settings
+	void setIOBackend(std::string backend);
+	void setChunkSize(size_t bytes);
+
+	//Stream interface, reads inputFd to the end and writes outputFd from where they are, pipes included
+	//The output has the same layout as the ".ANGELITA128" files, returns the bytes read from inputFd
+	std::uint64_t encryptStream(int inputFd, int outputFd, std::string mode);
+	std::uint64_t decryptStream(int inputFd, int outputFd, std::string mode);
+
+	//Async interface, C++20 coroutines for event loops (see ANGELITA128_Async.h), the same output as the blocking calls
+	//The tasks start when awaited, suspend on their reads and writes, run the cipher on io's executor and resume the awaiting
+	//coroutine on resumeExecutor; this object, io and the executors must outlive them
+	//The cbc IV comes from the caller: newIV() borrows the S-Box and P-Box, so it can't run while other tasks use this object
+	ANGELITA128_Task<void> encryptAsync(std::string file, std::string mode, std::array<unsigned char, 16> IV, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const;
+	ANGELITA128_Task<void> decryptAsync(std::string file, std::string mode, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const;
+	ANGELITA128_Task<std::uint64_t> encryptStreamAsync(int inputFd, int outputFd, std::string mode, std::array<unsigned char, 16> IV, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const;
+	ANGELITA128_Task<std::uint64_t> decryptStreamAsync(int inputFd, int outputFd, std::string mode, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const;
+	ANGELITA128_Task<size_t> encryptAsync(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV, ANGELITA128_Executor& cipherExecutor, ANGELITA128_Executor& resumeExecutor) const;
+	ANGELITA128_Task<size_t> decryptAsync(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV, ANGELITA128_Executor& cipherExecutor, ANGELITA128_Executor& resumeExecutor) const;
+
+	//Buffer interface, in memory and without allocating
+	//ecb and cbc are padded like the files, ctr and the cts modes keep the length; the IV is not part of the output
+	//input and output may be the same memory, but must not otherwise overlap
+	//The IV is always passed, ecb ignores it; encrypting in cbc, ctr or cbc_cts refuses an all-zero IV, the usual sign of a forgotten one
+	static size_t encryptedSize(size_t plaintextLength, ANGELITA128_Mode mode);
+	size_t encrypt(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) const;
+	size_t decrypt(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) const;
+	size_t encryptInPlace(std::span<std::uint8_t> buffer, size_t plaintextLength, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) const;
+	size_t decryptInPlace(std::span<std::uint8_t> buffer, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) const;
+
+	//Authenticated encryption: ctr over the data with a pmac of the ciphertext, made in the same pass
+	//The counter blocks start from S = E(nonce): E(S) masks the tag and the data uses S + 1 on, so nearby nonces such as a
+	//counter don't share keystream. A nonce used twice with one key repeats the keystream and tag mask: give every message its own,
+	//a counter or random bytes, and never reuse one after a crash or restore
+	//The output is the same length as the input; the blocks are spread over threadCount threads, 0 for one per core
+	void encryptAuthenticated(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, const std::array<unsigned char, 16>& nonce, std::array<unsigned char, 16>& tag, unsigned int threadCount = 1) const;
+	//The tag is checked against the ciphertext first, and nothing is written to output unless it matches
+	void decryptAuthenticated(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, const std::array<unsigned char, 16>& nonce, const std::array<unsigned char, 16>& tag, unsigned int threadCount = 1) const;
+
+	//Sector interface, XTS over ANGELITA128 for pages addressed by number, in place and the same length, no IV stored
+	//This object encrypts the data and tweakCipher, keyed with a different key, the sector numbers
+	//sectorSize is a multiple of 16 bytes, the batch versions work on sectorCount sectors one after the other from firstSector
+	void encryptSector(unsigned char* sector, size_t sectorSize, std::uint64_t sectorNumber, const ANGELITA128& tweakCipher) const;
+	void decryptSector(unsigned char* sector, size_t sectorSize, std::uint64_t sectorNumber, const ANGELITA128& tweakCipher) const;
+	void encryptSectors(unsigned char* sectors, size_t sectorSize, std::uint64_t firstSector, size_t sectorCount, const ANGELITA128& tweakCipher, unsigned int threadCount = 0) const;
+	void decryptSectors(unsigned char* sectors, size_t sectorSize, std::uint64_t firstSector, size_t sectorCount, const ANGELITA128& tweakCipher, unsigned int threadCount = 0) const;
+
+	//Small message fast path, the same output as the buffer interface but returning a status instead of throwing
+	//The IV or counter always comes from the caller, outputLength is set on OK
+	//encryptSmall refuses an all-zero IV outside ecb with ZERO_IV, as encrypt does by throwing
+	ANGELITA128_Status encryptSmall(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, size_t& outputLength, ANGELITA128_Mode mode, const std::array<unsigned char, 16>& IV) const noexcept;
+	ANGELITA128_Status decryptSmall(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, size_t& outputLength, ANGELITA128_Mode mode, const std::array<unsigned char, 16>& IV) const noexcept;
+	static const char* statusMessage(ANGELITA128_Status status) noexcept;
+
+	//Fingerprint: a tree hash made only of this object's block function, keyed, so the same data under the same key gives the
+	//same 16 bytes and nobody without the key can make or check one; 64 KiB leaves are hashed side by side in the lanes
+	//and spread over threadCount threads (0 for one per core), which doesn't change the result
+	std::array<unsigned char, 16> fingerprint(std::span<const std::uint8_t> data, unsigned int threadCount = 0) const;
+	std::array<unsigned char, 16> fingerprintFile(std::string file, unsigned int threadCount = 0) const;
+
+	//Chunked container interface, mode "cbc" or "ctr", threadCount 0 uses one thread per core
+	//codec "lz" compresses each chunk before it is encrypted, which helps text and logs; it is recorded in the header
+	//checksum records a CRC32C of the plaintext in the header, taken in the same pass, which decryptChunked and rekeyChunked
+	//check in theirs; each chunk's CRC32C is kept in the index, so updateChunked checks the chunks it reads and combines a new one
+	void encryptChunked(std::string file, std::string mode, size_t chunkSize = 65536, unsigned int threadCount = 0, std::string codec = "none", bool checksum = 0);
+	void decryptChunked(std::string file, unsigned int threadCount = 0);
+	std::vector<unsigned char> readChunked(std::string file, std::uint64_t offset, size_t length, unsigned int threadCount = 0) const;
+	void updateChunked(std::string file, std::uint64_t offset, const std::vector<unsigned char>& patch, unsigned int threadCount = 0);
+	//Re-key: decrypt with this object's key and encrypt with newCipher's in the same chunk, so the file is read and written once
+	//and the plaintext never reaches the disk; the result replaces the file under the same name once it is complete
+	//"ecb" and "cbc" files get a new IV and keep their length, containers get new chunk IVs and keep their layout
+	//Each chunk is split over threadCount threads (0 for one per core) as far as the mode allows
+	void rekey(std::string file, std::string mode, ANGELITA128& newCipher, unsigned int threadCount = 0) const;
+	void rekeyChunked(std::string file, ANGELITA128& newCipher, unsigned int threadCount = 0) const;
+	std::array<unsigned char, 16> chunkIV(std::array<unsigned char, 16> firstIV, std::uint64_t chunk) const;
+	size_t encryptChunk(std::string mode, const unsigned char* plaintext, unsigned char* stored, ANGELITA128_ChunkEntry& entry, unsigned char codec = ANGELITA128_Container::CODEC_NONE) const;
+	void decryptChunk(std::string mode, const unsigned char* stored, unsigned char* plaintext, const ANGELITA128_ChunkEntry& entry, unsigned char codec = ANGELITA128_Container::CODEC_NONE) const;
+	void decryptChunkRange(int fd, std::string mode, const ANGELITA128_ChunkEntry& entry, size_t start, size_t length, unsigned char* output, unsigned char codec = ANGELITA128_Container::CODEC_NONE) const;
+
+	//Archive interface, many small files packed into one file behind an encrypted table of contents
+	//paths are files, stored under their names, or directories, stored with everything under them; the originals are kept
+	//extractArchive decrypts one file by its stored path, unpackArchive writes them all out under directory
+	void packArchive(std::string archive, std::vector<std::string> paths, unsigned int threadCount = 0);
+	std::vector<ANGELITA128_ArchiveEntry> listArchive(std::string archive) const;
+	std::vector<unsigned char> extractArchive(std::string archive, std::string path, unsigned int threadCount = 0) const;
+	void unpackArchive(std::string archive, std::string directory, unsigned int threadCount = 0) const;
+
 };
 
 #endif
@@ -0,0 +1,475 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 archive methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 archive methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include "ANGELITA128_IO.h"
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+static const char ARCHIVE_MAGIC[8] = { 'A', 'N', 'G', 'E', 'L', 'A', 'R', 'C' };
+static const char TABLE_MAGIC[8] = { 'A', 'N', 'G', 'E', 'L', 'T', 'O', 'C' };
+
+//The data is packed and unpacked this many bytes at a time, a multiple of 16 so every batch starts on a block
+static const size_t ARCHIVE_BATCH = 4194304;
+
+//Blocks below this are not worth starting threads for
+static const size_t PARALLEL_BLOCKS = 4096;
+
+static void putU64(unsigned char* bytes, std::uint64_t value) {
+	for (unsigned int i = 0; i < 8; i++) {
+		bytes[i] = (value >> (8 * i)) & 255;
+	}
+}
+
+static std::uint64_t getU64(const unsigned char* bytes) {
+	std::uint64_t value = 0;
+	for (unsigned int i = 0; i < 8; i++) {
+		value |= (std::uint64_t)bytes[i] << (8 * i);
+	}
+	return value;
+}
+
+static bool safePath(const std::string& path) {
+	//Paths in an archive are relative and stay under the directory they are unpacked into
+	if (path.empty() || path[0] == '/' || path.find('\0') != std::string::npos) {
+		return 0;
+	}
+	size_t start = 0;
+	while (start <= path.size()) {
+		size_t end = path.find('/', start);
+		if (end == std::string::npos) {
+			end = path.size();
+		}
+		std::string part = path.substr(start, end - start);
+		if (part.empty() || part == "." || part == "..") {
+			return 0;
+		}
+		start = end + 1;
+	}
+	return 1;
+}
+
+ANGELITA128_ArchiveHeader ANGELITA128_Archive::readHeader(int fd) {
+	//Read and check the archive header
+	unsigned char bytes[HEADER_SIZE];
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size < HEADER_SIZE) {
+		throw ANGELITA128_Exception("ANGELITA128: File is not an ANGELITA128 archive.");
+	}
+	ANGELITA128_IO::readAt(fd, bytes, HEADER_SIZE, 0);
+	if (std::memcmp(bytes, ARCHIVE_MAGIC, 8) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: File is not an ANGELITA128 archive.");
+	}
+	ANGELITA128_ArchiveHeader header;
+	header.version = bytes[8];
+	std::memcpy(header.IV.data(), bytes + 16, 16);
+	header.dataLength = getU64(bytes + 32);
+	header.tableOffset = getU64(bytes + 40);
+	header.tableLength = getU64(bytes + 48);
+	if (header.version != 1) {
+		throw ANGELITA128_Exception("ANGELITA128: Archive version is not supported.");
+	}
+	if (header.tableOffset != HEADER_SIZE + header.dataLength || header.tableLength < 16 ||
+		header.tableOffset + header.tableLength > (std::uint64_t)fileStat.st_size) {
+		throw ANGELITA128_Exception("ANGELITA128: Archive header is damaged.");
+	}
+	return header;
+}
+
+void ANGELITA128_Archive::writeHeader(int fd, const ANGELITA128_ArchiveHeader& header) {
+	unsigned char bytes[HEADER_SIZE] = {};
+	std::memcpy(bytes, ARCHIVE_MAGIC, 8);
+	bytes[8] = header.version;
+	std::memcpy(bytes + 16, header.IV.data(), 16);
+	putU64(bytes + 32, header.dataLength);
+	putU64(bytes + 40, header.tableOffset);
+	putU64(bytes + 48, header.tableLength);
+	ANGELITA128_IO::writeAt(fd, bytes, HEADER_SIZE, 0);
+}
+
+std::vector<unsigned char> ANGELITA128_Archive::packTable(const std::vector<ANGELITA128_ArchiveEntry>& entries) {
+	//Lay out the table of contents, before it is encrypted
+	size_t tableLength = 16;
+	for (const ANGELITA128_ArchiveEntry& entry : entries) {
+		tableLength += 18 + entry.path.size();
+	}
+	std::vector<unsigned char> table(tableLength);
+	std::memcpy(table.data(), TABLE_MAGIC, 8);
+	putU64(table.data() + 8, entries.size());
+	unsigned char* entryBytes = table.data() + 16;
+	for (const ANGELITA128_ArchiveEntry& entry : entries) {
+		entryBytes[0] = entry.path.size() & 255;
+		entryBytes[1] = entry.path.size() >> 8;
+		std::memcpy(entryBytes + 2, entry.path.data(), entry.path.size());
+		entryBytes += 2 + entry.path.size();
+		putU64(entryBytes, entry.offset);
+		putU64(entryBytes + 8, entry.length);
+		entryBytes += 16;
+	}
+	return table;
+}
+
+std::vector<ANGELITA128_ArchiveEntry> ANGELITA128_Archive::unpackTable(const std::vector<unsigned char>& table, std::uint64_t dataLength) {
+	//Read back the decrypted table of contents, checking that the files are sorted, safe to unpack and fill the data exactly
+	if (table.size() < 16 || std::memcmp(table.data(), TABLE_MAGIC, 8) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Archive table of contents did not decrypt, wrong key or damaged archive.");
+	}
+	std::uint64_t fileCount = getU64(table.data() + 8);
+	if (fileCount > (table.size() - 16) / 18) {
+		throw ANGELITA128_Exception("ANGELITA128: Archive table of contents is damaged.");
+	}
+	std::vector<ANGELITA128_ArchiveEntry> entries(fileCount);
+	size_t position = 16;
+	std::uint64_t dataEnd = 0;
+	for (std::uint64_t f = 0; f < fileCount; f++) {
+		ANGELITA128_ArchiveEntry& entry = entries[f];
+		if (table.size() - position < 18) {
+			throw ANGELITA128_Exception("ANGELITA128: Archive table of contents is damaged.");
+		}
+		size_t pathLength = table[position] | (table[position + 1] << 8);
+		if (table.size() - position - 2 < pathLength + 16) {
+			throw ANGELITA128_Exception("ANGELITA128: Archive table of contents is damaged.");
+		}
+		entry.path.assign((const char*)table.data() + position + 2, pathLength);
+		position += 2 + pathLength;
+		entry.offset = getU64(table.data() + position);
+		entry.length = getU64(table.data() + position + 8);
+		position += 16;
+		if (!safePath(entry.path) || (f > 0 && entry.path <= entries[f - 1].path) ||
+			entry.offset != dataEnd || entry.length > dataLength - dataEnd) {
+			throw ANGELITA128_Exception("ANGELITA128: Archive table of contents is damaged.");
+		}
+		dataEnd += entry.length;
+	}
+	if (position != table.size() || dataEnd != dataLength) {
+		throw ANGELITA128_Exception("ANGELITA128: Archive table of contents is damaged.");
+	}
+	return entries;
+}
+
+
+///////////////////
+//Archive routines
+///////////////////
+
+void ANGELITA128::archiveCTR(unsigned char* data, size_t length, std::uint64_t dataOffset, const std::array<unsigned char, 16>& IV, unsigned int threadCount) const {
+	//Encrypt or decrypt length bytes of the archive's ctr stream in place, starting at dataOffset, a multiple of 16
+	//Long runs are split into one piece of whole blocks per thread, each piece finding its own counter
+	size_t blockCount = (length + 15) / 16;
+	size_t pieces = blockCount < PARALLEL_BLOCKS ? 1 : threadCount;
+	if (pieces > blockCount) {
+		pieces = blockCount;
+	}
+	if (pieces <= 1) {
+		std::array<unsigned char, 16> counterBlock = IV;
+		counterAdd(counterBlock, dataOffset / 16);
+		this->encryptCTR(data, data, length, counterBlock);
+		return;
+	}
+	size_t pieceBlocks = (blockCount + pieces - 1) / pieces;
+	parallelFor(pieces, pieces, [&](size_t piece) {
+		size_t first = piece * pieceBlocks * 16;
+		if (first >= length) {
+			return;
+		}
+		size_t count = std::min(length - first, pieceBlocks * 16);
+		std::array<unsigned char, 16> counterBlock = IV;
+		counterAdd(counterBlock, (dataOffset + first) / 16);
+		this->encryptCTR(data + first, data + first, count, counterBlock);
+	});
+}
+
+std::vector<ANGELITA128_ArchiveEntry> ANGELITA128::readArchiveTable(int fd, const ANGELITA128_ArchiveHeader& header) const {
+	//Read and decrypt the table of contents, its counter carries on after the data's last block
+	std::vector<unsigned char> table(header.tableLength);
+	ANGELITA128_IO::readAt(fd, table.data(), table.size(), header.tableOffset);
+	std::array<unsigned char, 16> counterBlock = header.IV;
+	counterAdd(counterBlock, (header.dataLength + 15) / 16);
+	this->decryptCTR(table.data(), table.data(), table.size(), counterBlock);
+	return ANGELITA128_Archive::unpackTable(table, header.dataLength);
+}
+
+
+///////////////////
+//Archive interface
+///////////////////
+
+void ANGELITA128::packArchive(std::string archive, std::vector<std::string> paths, unsigned int threadCount) {
+	//Pack the files and directories into one archive, each stored under its own name and directories with what is under them
+	//The files are read into large batches and each batch is encrypted in parallel, so there is one IV and no padding per file
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to encrypt.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+
+	std::vector<std::pair<ANGELITA128_ArchiveEntry, std::string>> files;
+	for (std::string path : paths) {
+		std::error_code err;
+		std::filesystem::path base = std::filesystem::absolute(path, err).lexically_normal();
+		if (!base.has_filename()) {
+			base = base.parent_path();
+		}
+		std::filesystem::path name = base.filename();
+		if (std::filesystem::is_directory(path, err)) {
+			for (auto it = std::filesystem::recursive_directory_iterator(path, std::filesystem::directory_options::skip_permission_denied, err);
+				it != std::filesystem::recursive_directory_iterator(); it.increment(err)) {
+				if (err) {
+					break;
+				}
+				if (it->is_regular_file(err)) {
+					ANGELITA128_ArchiveEntry entry;
+					entry.path = (name / it->path().lexically_relative(path)).lexically_normal().generic_string();
+					files.push_back({ entry, it->path().string() });
+				}
+			}
+		}
+		else if (std::filesystem::is_regular_file(path, err)) {
+			ANGELITA128_ArchiveEntry entry;
+			entry.path = name.generic_string();
+			files.push_back({ entry, path });
+		}
+		else {
+			throw ANGELITA128_Exception("ANGELITA128: Could not open file or directory to archive.");
+		}
+	}
+	std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first.path < b.first.path; });
+
+	ANGELITA128_ArchiveHeader header;
+	std::vector<ANGELITA128_ArchiveEntry> entries;
+	std::vector<std::string> sources;
+	for (auto& file : files) {
+		if (!safePath(file.first.path) || file.first.path.size() > ANGELITA128_Archive::MAX_PATH) {
+			throw ANGELITA128_Exception("ANGELITA128: File can not be stored in an archive under its name.");
+		}
+		if (!entries.empty() && entries.back().path == file.first.path) {
+			throw ANGELITA128_Exception("ANGELITA128: Two files would be stored in the archive under the same name.");
+		}
+		struct stat fileStat;
+		if (stat(file.second.c_str(), &fileStat) != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not open file to archive.");
+		}
+		file.first.offset = header.dataLength;
+		file.first.length = fileStat.st_size;
+		header.dataLength += file.first.length;
+		entries.push_back(file.first);
+		sources.push_back(file.second);
+	}
+
+	int outputFd = open(archive.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (outputFd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open archive for write.");
+	}
+	int inputFd = -1;
+	try {
+		//GLORIA borrows the S-Box and P-Box, so it runs before the batch threads
+		header.IV = this->GLORIA();
+		std::vector<unsigned char> batch(std::min<std::uint64_t>(ARCHIVE_BATCH, header.dataLength));
+		size_t fileIndex = 0;
+		std::uint64_t fileDone = 0;
+		for (std::uint64_t dataOffset = 0; dataOffset < header.dataLength; dataOffset += batch.size()) {
+			size_t batchLength = std::min<std::uint64_t>(batch.size(), header.dataLength - dataOffset);
+			size_t filled = 0;
+			while (filled < batchLength) {
+				size_t piece = std::min<std::uint64_t>(entries[fileIndex].length - fileDone, batchLength - filled);
+				if (piece > 0) {
+					if (inputFd < 0) {
+						inputFd = open(sources[fileIndex].c_str(), O_RDONLY);
+						if (inputFd < 0) {
+							throw ANGELITA128_Exception("ANGELITA128: Could not open file to archive.");
+						}
+					}
+					ANGELITA128_IO::readAt(inputFd, batch.data() + filled, piece, fileDone);
+				}
+				filled += piece;
+				fileDone += piece;
+				if (fileDone == entries[fileIndex].length) {
+					if (inputFd >= 0) {
+						close(inputFd);
+						inputFd = -1;
+					}
+					fileIndex++;
+					fileDone = 0;
+				}
+			}
+			this->archiveCTR(batch.data(), batchLength, dataOffset, header.IV, threadCount);
+			ANGELITA128_IO::writeAt(outputFd, batch.data(), batchLength, ANGELITA128_Archive::HEADER_SIZE + dataOffset);
+		}
+
+		std::vector<unsigned char> table = ANGELITA128_Archive::packTable(entries);
+		std::array<unsigned char, 16> counterBlock = header.IV;
+		counterAdd(counterBlock, (header.dataLength + 15) / 16);
+		this->encryptCTR(table.data(), table.data(), table.size(), counterBlock);
+		header.tableOffset = ANGELITA128_Archive::HEADER_SIZE + header.dataLength;
+		header.tableLength = table.size();
+		ANGELITA128_IO::writeAt(outputFd, table.data(), table.size(), header.tableOffset);
+		ANGELITA128_Archive::writeHeader(outputFd, header);
+	}
+	catch (...) {
+		if (inputFd >= 0) {
+			close(inputFd);
+		}
+		close(outputFd);
+		unlink(archive.c_str());
+		throw;
+	}
+	if (close(outputFd) != 0) {
+		unlink(archive.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not write archive.");
+	}
+}
+
+std::vector<ANGELITA128_ArchiveEntry> ANGELITA128::listArchive(std::string archive) const {
+	//Decrypt only the table of contents
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	int fd = open(archive.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open archive for read.");
+	}
+	std::vector<ANGELITA128_ArchiveEntry> entries;
+	try {
+		entries = this->readArchiveTable(fd, ANGELITA128_Archive::readHeader(fd));
+	}
+	catch (...) {
+		close(fd);
+		throw;
+	}
+	close(fd);
+	return entries;
+}
+
+std::vector<unsigned char> ANGELITA128::extractArchive(std::string archive, std::string path, unsigned int threadCount) const {
+	//Find one file in the table of contents and decrypt only its blocks
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+	int fd = open(archive.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open archive for read.");
+	}
+	std::vector<unsigned char> output;
+	try {
+		ANGELITA128_ArchiveHeader header = ANGELITA128_Archive::readHeader(fd);
+		std::vector<ANGELITA128_ArchiveEntry> entries = this->readArchiveTable(fd, header);
+		auto found = std::lower_bound(entries.begin(), entries.end(), path,
+			[](const ANGELITA128_ArchiveEntry& entry, const std::string& key) { return entry.path < key; });
+		if (found == entries.end() || found->path != path) {
+			throw ANGELITA128_Exception("ANGELITA128: File is not in the archive.");
+		}
+		std::uint64_t firstByte = found->offset / 16 * 16;
+		size_t skip = found->offset - firstByte;
+		output.resize(skip + found->length);
+		ANGELITA128_IO::readAt(fd, output.data(), output.size(), ANGELITA128_Archive::HEADER_SIZE + firstByte);
+		this->archiveCTR(output.data(), output.size(), firstByte, header.IV, threadCount);
+		output.erase(output.begin(), output.begin() + skip);
+	}
+	catch (...) {
+		close(fd);
+		throw;
+	}
+	close(fd);
+	return output;
+}
+
+void ANGELITA128::unpackArchive(std::string archive, std::string directory, unsigned int threadCount) const {
+	//Unpack every file in the archive under the directory, decrypting the data a batch at a time in parallel
+	//The archive itself is left as it is
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+	int inputFd = open(archive.c_str(), O_RDONLY);
+	if (inputFd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open archive for read.");
+	}
+	int outputFd = -1;
+	try {
+		ANGELITA128_ArchiveHeader header = ANGELITA128_Archive::readHeader(inputFd);
+		std::vector<ANGELITA128_ArchiveEntry> entries = this->readArchiveTable(inputFd, header);
+		std::filesystem::path root(directory);
+		std::vector<unsigned char> batch(std::min<std::uint64_t>(ARCHIVE_BATCH, header.dataLength));
+		size_t fileIndex = 0;
+		std::uint64_t fileDone = 0;
+		std::uint64_t dataOffset = 0;
+		//Every file gets its turn, the empty ones after the last batch too
+		while (fileIndex < entries.size()) {
+			size_t batchLength = std::min<std::uint64_t>(batch.size(), header.dataLength - dataOffset);
+			ANGELITA128_IO::readAt(inputFd, batch.data(), batchLength, ANGELITA128_Archive::HEADER_SIZE + dataOffset);
+			this->archiveCTR(batch.data(), batchLength, dataOffset, header.IV, threadCount);
+			size_t used = 0;
+			while (fileIndex < entries.size()) {
+				if (outputFd < 0) {
+					std::filesystem::path target = root / entries[fileIndex].path;
+					std::error_code err;
+					std::filesystem::create_directories(target.parent_path(), err);
+					outputFd = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+					if (outputFd < 0) {
+						throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after unpacking.");
+					}
+				}
+				size_t piece = std::min<std::uint64_t>(entries[fileIndex].length - fileDone, batchLength - used);
+				ANGELITA128_IO::writeAt(outputFd, batch.data() + used, piece, fileDone);
+				used += piece;
+				fileDone += piece;
+				if (fileDone < entries[fileIndex].length) {
+					break;
+				}
+				int fileFd = outputFd;
+				outputFd = -1;
+				if (close(fileFd) != 0) {
+					throw ANGELITA128_Exception("ANGELITA128: Could not write file after unpacking.");
+				}
+				fileIndex++;
+				fileDone = 0;
+			}
+			dataOffset += batchLength;
+		}
+	}
+	catch (...) {
+		if (outputFd >= 0) {
+			close(outputFd);
+		}
+		close(inputFd);
+		throw;
+	}
+	close(inputFd);
+}
@@ -0,0 +1,86 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 archive header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 archive class
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+/*
+	Archive layout, all numbers little endian:
+
+	Header (64 bytes):
+		magic "ANGELARC", version, reserved (7), IV (16),
+		data length (8), table offset (8), table length (8), reserved (8)
+	Data:
+		the files one after the other with nothing between them, encrypted as one ctr stream from the IV
+	Table of contents (after the data):
+		"ANGELTOC", file count (8), then for each file, sorted by path:
+		path length (2), path, offset in the data (8), length (8)
+		encrypted in ctr mode, its counter carrying on from the block after the last data block
+
+	The file at data offset N starts in the block with counter IV + N / 16,
+	so any one file can be decrypted without the ones before it.
+*/
+
+#ifndef ANGELITA128_ARCHIVE_H
+#define ANGELITA128_ARCHIVE_H
+
+#include "ANGELITA128_Exception.h"
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct ANGELITA128_ArchiveHeader {
+	unsigned char version = 1;
+	std::array<unsigned char, 16> IV = {};
+	std::uint64_t dataLength = 0;
+	std::uint64_t tableOffset = 0;
+	std::uint64_t tableLength = 0;
+};
+
+struct ANGELITA128_ArchiveEntry {
+	std::string path;
+	std::uint64_t offset = 0;
+	std::uint64_t length = 0;
+};
+
+class ANGELITA128_Archive {
+public:
+	static const unsigned int HEADER_SIZE = 64;
+	static const unsigned int MAX_PATH = 65535;
+
+	static ANGELITA128_ArchiveHeader readHeader(int fd);
+	static void writeHeader(int fd, const ANGELITA128_ArchiveHeader& header);
+	static std::vector<unsigned char> packTable(const std::vector<ANGELITA128_ArchiveEntry>& entries);
+	static std::vector<ANGELITA128_ArchiveEntry> unpackTable(const std::vector<unsigned char>& table, std::uint64_t dataLength);
+};
+
+#endif
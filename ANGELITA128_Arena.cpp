@@ -0,0 +1,209 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 buffer arena methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 buffer arena methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_Arena.h"
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <sys/mman.h>
+
+static const size_t PAGE_SIZE = 4096;
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+static std::atomic<bool> useHugePages(0);
+static std::atomic<std::uint64_t> requestCount(0);
+static std::atomic<std::uint64_t> reusedCount(0);
+static std::atomic<std::uint64_t> mappedCount(0);
+static std::atomic<std::uint64_t> bytesInUse(0);
+static std::atomic<std::uint64_t> bytesMapped(0);
+static std::atomic<std::uint64_t> highWater(0);
+
+static void unmapBuffer(unsigned char* bytes, size_t capacity) {
+	//Hand a buffer back to the kernel
+	munmap(bytes, capacity);
+	bytesMapped -= capacity;
+}
+
+struct ANGELITA128_ArenaCache {
+	//The buffers a thread has given back, as (capacity, address)
+	std::vector<std::pair<size_t, unsigned char*>> buffers;
+
+	ANGELITA128_ArenaCache() {
+		buffers.reserve(ANGELITA128_Arena::MAX_CACHED);
+	}
+	~ANGELITA128_ArenaCache() {
+		for (auto& buffer : buffers) {
+			unmapBuffer(buffer.second, buffer.first);
+		}
+	}
+};
+
+static thread_local ANGELITA128_ArenaCache cache;
+
+
+///////////////////
+//Arena
+///////////////////
+
+unsigned char* ANGELITA128_Arena::take(size_t size, size_t& capacity) {
+	//The smallest kept buffer that fits, else a new mapping
+	requestCount++;
+	unsigned int best = cache.buffers.size();
+	for (unsigned int i = 0; i < cache.buffers.size(); i++) {
+		if (cache.buffers[i].first >= size && (best == cache.buffers.size() || cache.buffers[i].first < cache.buffers[best].first)) {
+			best = i;
+		}
+	}
+	if (best < cache.buffers.size()) {
+		unsigned char* bytes = cache.buffers[best].second;
+		capacity = cache.buffers[best].first;
+		cache.buffers[best] = cache.buffers.back();
+		cache.buffers.pop_back();
+		reusedCount++;
+		bytesInUse += capacity;
+		return bytes;
+	}
+
+	void* bytes = MAP_FAILED;
+	bool huge = useHugePages && size >= HUGE_PAGE_SIZE;
+	if (huge) {
+		capacity = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+		bytes = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+	}
+	else {
+		capacity = (size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+	}
+	if (bytes == MAP_FAILED) {
+		bytes = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (bytes == MAP_FAILED) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not allocate buffer.");
+		}
+#ifdef MADV_HUGEPAGE
+		if (huge) {
+			madvise(bytes, capacity, MADV_HUGEPAGE);
+		}
+#endif
+	}
+	mappedCount++;
+	bytesInUse += capacity;
+	std::uint64_t mapped = bytesMapped += capacity;
+	std::uint64_t peak = highWater;
+	while (mapped > peak && !highWater.compare_exchange_weak(peak, mapped)) {
+	}
+	return (unsigned char*)bytes;
+}
+
+void ANGELITA128_Arena::give(unsigned char* bytes, size_t capacity) {
+	//Keep the buffer for this thread's next request, or unmap it if the thread already keeps enough
+	bytesInUse -= capacity;
+	if (cache.buffers.size() < MAX_CACHED) {
+		cache.buffers.push_back({capacity, bytes});
+		return;
+	}
+	//Keep the larger one
+	unsigned int smallest = 0;
+	for (unsigned int i = 1; i < cache.buffers.size(); i++) {
+		if (cache.buffers[i].first < cache.buffers[smallest].first) {
+			smallest = i;
+		}
+	}
+	if (cache.buffers[smallest].first < capacity) {
+		std::swap(cache.buffers[smallest].first, capacity);
+		std::swap(cache.buffers[smallest].second, bytes);
+	}
+	unmapBuffer(bytes, capacity);
+}
+
+void ANGELITA128_Arena::setHugePages(bool use) {
+	useHugePages = use;
+}
+
+ANGELITA128_ArenaStats ANGELITA128_Arena::stats() {
+	ANGELITA128_ArenaStats stats;
+	stats.requests = requestCount;
+	stats.reused = reusedCount;
+	stats.mapped = mappedCount;
+	stats.bytesInUse = bytesInUse;
+	stats.bytesMapped = bytesMapped;
+	stats.highWater = highWater;
+	return stats;
+}
+
+void ANGELITA128_Arena::showStats() {
+	ANGELITA128_ArenaStats stats = ANGELITA128_Arena::stats();
+	std::cout << "Buffer requests: " << stats.requests << " (" << stats.reused << " reused, " << stats.mapped << " mapped)\n";
+	std::cout << "Bytes in use: " << stats.bytesInUse << ", mapped: " << stats.bytesMapped << ", high water: " << stats.highWater << "\n";
+}
+
+void ANGELITA128_Arena::trim() {
+	for (auto& buffer : cache.buffers) {
+		unmapBuffer(buffer.second, buffer.first);
+	}
+	cache.buffers.clear();
+}
+
+
+///////////////////
+//Buffer
+///////////////////
+
+ANGELITA128_ArenaBuffer::ANGELITA128_ArenaBuffer(size_t size) : length(size) {
+	if (size > 0) {
+		this->bytes = ANGELITA128_Arena::take(size, this->capacity);
+	}
+}
+
+ANGELITA128_ArenaBuffer::~ANGELITA128_ArenaBuffer() {
+	if (this->bytes) {
+		ANGELITA128_Arena::give(this->bytes, this->capacity);
+	}
+}
+
+ANGELITA128_ArenaBuffer::ANGELITA128_ArenaBuffer(ANGELITA128_ArenaBuffer&& other) noexcept : bytes(other.bytes), length(other.length), capacity(other.capacity) {
+	other.bytes = nullptr;
+	other.length = 0;
+	other.capacity = 0;
+}
+
+ANGELITA128_ArenaBuffer& ANGELITA128_ArenaBuffer::operator=(ANGELITA128_ArenaBuffer&& other) noexcept {
+	std::swap(this->bytes, other.bytes);
+	std::swap(this->length, other.length);
+	std::swap(this->capacity, other.capacity);
+	return *this;
+}
@@ -0,0 +1,102 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 buffer arena header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 buffer arena class
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+/*
+	The chunk buffers of the I/O backends and of batch jobs come from here instead of the heap.
+
+	Each thread keeps the buffers it gave back, and takes the smallest one big enough when it next needs one. The
+	scheduler's threads last for the whole process, so a batch job only maps buffers for its first few files and
+	reuses them for the rest. Buffers are mapped straight from the kernel, page aligned and rounded up to whole
+	pages, or to 2 MiB huge pages once setHugePages is on and the buffer is that large. A thread keeps at most
+	MAX_CACHED buffers, more than that go back to the kernel.
+
+	Buffers are handed out as they were left, not cleared.
+*/
+
+#ifndef ANGELITA128_ARENA_H
+#define ANGELITA128_ARENA_H
+
+#include "ANGELITA128_Exception.h"
+#include <cstddef>
+#include <cstdint>
+
+struct ANGELITA128_ArenaStats {
+	std::uint64_t requests = 0;
+	//Requests served from a thread's kept buffers, the rest were mapped
+	std::uint64_t reused = 0;
+	std::uint64_t mapped = 0;
+	//Bytes handed out right now, and bytes mapped (handed out or kept)
+	std::uint64_t bytesInUse = 0;
+	std::uint64_t bytesMapped = 0;
+	//The most bytes ever mapped at once
+	std::uint64_t highWater = 0;
+};
+
+class ANGELITA128_ArenaBuffer {
+private:
+	unsigned char* bytes = nullptr;
+	size_t length = 0;
+	size_t capacity = 0;
+
+public:
+	ANGELITA128_ArenaBuffer() {}
+	//A buffer of at least size bytes from this thread's arena
+	explicit ANGELITA128_ArenaBuffer(size_t size);
+	~ANGELITA128_ArenaBuffer();
+	ANGELITA128_ArenaBuffer(ANGELITA128_ArenaBuffer&& other) noexcept;
+	ANGELITA128_ArenaBuffer& operator=(ANGELITA128_ArenaBuffer&& other) noexcept;
+	ANGELITA128_ArenaBuffer(const ANGELITA128_ArenaBuffer&) = delete;
+	ANGELITA128_ArenaBuffer& operator=(const ANGELITA128_ArenaBuffer&) = delete;
+
+	unsigned char* data() const { return this->bytes; }
+	size_t size() const { return this->length; }
+};
+
+class ANGELITA128_Arena {
+private:
+	friend class ANGELITA128_ArenaBuffer;
+	static unsigned char* take(size_t size, size_t& capacity);
+	static void give(unsigned char* bytes, size_t capacity);
+
+public:
+	static const unsigned int MAX_CACHED = 16;
+
+	//Back buffers of 2 MiB and more with huge pages, reserved ones if there are any, else transparent ones
+	static void setHugePages(bool use);
+	static ANGELITA128_ArenaStats stats();
+	static void showStats();
+	//Give this thread's kept buffers back to the kernel
+	static void trim();
+};
+
+#endif
@@ -0,0 +1,585 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 async methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 coroutine executor, async I/O and async encryption methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include <regex>
+#include <climits>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef ANGELITA128_IO_URING
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#endif
+
+
+///////////////////
+//Thread pool executor
+///////////////////
+
+ANGELITA128_ThreadPoolExecutor::ANGELITA128_ThreadPoolExecutor(unsigned int threadCount) {
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0) {
+			threadCount = 1;
+		}
+	}
+	for (unsigned int t = 0; t < threadCount; t++) {
+		this->threads.emplace_back(&ANGELITA128_ThreadPoolExecutor::serve, this);
+	}
+}
+
+ANGELITA128_ThreadPoolExecutor::~ANGELITA128_ThreadPoolExecutor() {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->stopping = 1;
+	}
+	this->workReady.notify_all();
+	for (std::thread& thread : this->threads) {
+		thread.join();
+	}
+}
+
+void ANGELITA128_ThreadPoolExecutor::post(std::function<void()> work) {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->work.push_back(std::move(work));
+	}
+	this->workReady.notify_one();
+}
+
+void ANGELITA128_ThreadPoolExecutor::serve() {
+	//Pool thread: run work in the order it was posted, until stopping and nothing is left
+	for (;;) {
+		std::function<void()> next;
+		{
+			std::unique_lock<std::mutex> guard(this->lock);
+			this->workReady.wait(guard, [&]() { return this->stopping || !this->work.empty(); });
+			if (this->work.empty()) {
+				return;
+			}
+			next = std::move(this->work.front());
+			this->work.pop_front();
+		}
+		next();
+	}
+}
+
+
+///////////////////
+//Async I/O
+///////////////////
+
+ANGELITA128_AsyncIO::ANGELITA128_AsyncIO(ANGELITA128_Executor& executor, std::string backend, unsigned int queueDepth) : executor(executor), queueDepth(std::max(queueDepth, 1u)) {
+	//Start the thread serving the ring, or the blocking threads
+	if (backend != "auto" && backend != "io_uring" && backend != "blocking") {
+		throw ANGELITA128_Exception("ANGELITA128: Unknown async I/O backend, must be \"auto\", \"io_uring\" or \"blocking\".");
+	}
+#ifdef ANGELITA128_IO_URING
+	if (backend != "blocking") {
+		try {
+			//One more entry than queueDepth, for the read of wakeFd that is always in the ring
+			this->ring.reset(new ANGELITA128_UringIO(this->queueDepth + 1));
+			this->wakeFd = eventfd(0, EFD_CLOEXEC);
+			if (this->wakeFd < 0) {
+				throw ANGELITA128_Exception("ANGELITA128: io_uring is not available.");
+			}
+			this->threads.emplace_back(&ANGELITA128_AsyncIO::serveRing, this);
+			return;
+		}
+		catch (ANGELITA128_Exception& err) {
+			this->ring.reset();
+			if (backend == "io_uring") {
+				throw;
+			}
+		}
+	}
+#else
+	if (backend == "io_uring") {
+		throw ANGELITA128_Exception("ANGELITA128: The io_uring backend is not available on this system.");
+	}
+#endif
+	for (unsigned int t = 0; t < this->queueDepth; t++) {
+		this->threads.emplace_back(&ANGELITA128_AsyncIO::serveBlocking, this);
+	}
+}
+
+ANGELITA128_AsyncIO::~ANGELITA128_AsyncIO() {
+	//Requests already made are finished first
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->stopping = 1;
+	}
+	this->requestsReady.notify_all();
+#ifdef ANGELITA128_IO_URING
+	if (this->wakeFd >= 0) {
+		std::uint64_t wake = 1;
+		if (::write(this->wakeFd, &wake, 8) < 0) {
+			//An eventfd only refuses a write at its maximum count, when the thread is already woken
+		}
+	}
+#endif
+	for (std::thread& thread : this->threads) {
+		thread.join();
+	}
+#ifdef ANGELITA128_IO_URING
+	this->ring.reset();
+	if (this->wakeFd >= 0) {
+		close(this->wakeFd);
+	}
+#endif
+}
+
+std::string ANGELITA128_AsyncIO::name() const {
+#ifdef ANGELITA128_IO_URING
+	if (this->ring) {
+		return "io_uring";
+	}
+#endif
+	return "blocking";
+}
+
+ANGELITA128_AsyncIO::Request ANGELITA128_AsyncIO::read(int fd, unsigned char* buffer, size_t length, std::uint64_t offset) {
+	return Request{ this, fd, 0, buffer, length, offset, 0, {} };
+}
+
+ANGELITA128_AsyncIO::Request ANGELITA128_AsyncIO::write(int fd, const unsigned char* buffer, size_t length, std::uint64_t offset) {
+	return Request{ this, fd, 1, (unsigned char*)buffer, length, offset, 0, {} };
+}
+
+void ANGELITA128_AsyncIO::Request::await_suspend(std::coroutine_handle<> waiting) {
+	//Once queued the request may finish and its coroutine resume on another thread, so only io is used after
+	this->waiting = waiting;
+	ANGELITA128_AsyncIO* io = this->io;
+	{
+		std::lock_guard<std::mutex> guard(io->lock);
+		io->requests.push_back(this);
+	}
+	io->requestsReady.notify_one();
+#ifdef ANGELITA128_IO_URING
+	if (io->wakeFd >= 0) {
+		std::uint64_t wake = 1;
+		if (::write(io->wakeFd, &wake, 8) < 0) {
+			//Already woken, see the destructor
+		}
+	}
+#endif
+}
+
+size_t ANGELITA128_AsyncIO::Request::await_resume() const {
+	if (this->result < 0) {
+		if (this->writing) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not write during async I/O.");
+		}
+		throw ANGELITA128_Exception("ANGELITA128: Could not read during async I/O.");
+	}
+	return this->result;
+}
+
+void ANGELITA128_AsyncIO::finish(Request* request, long long result) {
+	//Hand the request's coroutine to the executor, it owns the request from here
+	request->result = result;
+	std::coroutine_handle<> waiting = request->waiting;
+	this->executor.post([waiting]() { waiting.resume(); });
+}
+
+void ANGELITA128_AsyncIO::serveBlocking() {
+	//Blocking thread: one read or write at a time, until stopping and nothing is left
+	for (;;) {
+		Request* request;
+		{
+			std::unique_lock<std::mutex> guard(this->lock);
+			this->requestsReady.wait(guard, [&]() { return this->stopping || !this->requests.empty(); });
+			if (this->requests.empty()) {
+				return;
+			}
+			request = this->requests.front();
+			this->requests.pop_front();
+		}
+		ssize_t result;
+		do {
+			if (request->offset == CURRENT_POSITION) {
+				result = request->writing ? ::write(request->fd, request->buffer, request->length) : ::read(request->fd, request->buffer, request->length);
+			}
+			else if (request->writing) {
+				result = pwrite(request->fd, request->buffer, request->length, request->offset);
+			}
+			else {
+				result = pread(request->fd, request->buffer, request->length, request->offset);
+			}
+		} while (result < 0 && errno == EINTR);
+		this->finish(request, result < 0 ? -errno : result);
+	}
+}
+
+#ifdef ANGELITA128_IO_URING
+
+void ANGELITA128_AsyncIO::serveRing() {
+	//Ring thread: keep up to queueDepth requests in the ring and finish them as they complete
+	//A read of wakeFd (user data 0) is always in the ring too, so a new request or stopping ends the wait for completions
+	auto submitWake = [&]() {
+		this->ring->submit(IORING_OP_READ, this->wakeFd, (unsigned char*)&this->wakeCount, 8, 0, -1, 0);
+	};
+	auto submitRequest = [&](Request* request) {
+		unsigned int length = std::min<size_t>(request->length, INT_MAX);
+		this->ring->submit(request->writing ? IORING_OP_WRITE : IORING_OP_READ, request->fd, request->buffer, length, request->offset, -1, (std::uint64_t)(uintptr_t)request);
+	};
+	submitWake();
+	unsigned int inFlight = 0;
+	for (;;) {
+		{
+			std::lock_guard<std::mutex> guard(this->lock);
+			if (this->stopping && this->requests.empty() && inFlight == 0) {
+				return;
+			}
+			while (!this->requests.empty() && inFlight < this->queueDepth) {
+				submitRequest(this->requests.front());
+				this->requests.pop_front();
+				inFlight++;
+			}
+		}
+		std::uint64_t userData;
+		int result;
+		this->ring->waitCompletion(userData, result);
+		if (userData == 0) {
+			submitWake();
+			continue;
+		}
+		Request* request = (Request*)(uintptr_t)userData;
+		if (result == -EINTR || result == -EAGAIN) {
+			submitRequest(request);
+			continue;
+		}
+		inFlight--;
+		this->finish(request, result);
+	}
+}
+
+#endif
+
+ANGELITA128_Task<size_t> ANGELITA128_AsyncIO::readFull(int fd, unsigned char* buffer, size_t length, std::uint64_t offset) {
+	size_t done = 0;
+	while (done < length) {
+		size_t got = co_await this->read(fd, buffer + done, length - done, offset == CURRENT_POSITION ? offset : offset + done);
+		if (got == 0) {
+			break;
+		}
+		done += got;
+	}
+	co_return done;
+}
+
+ANGELITA128_Task<void> ANGELITA128_AsyncIO::writeFull(int fd, const unsigned char* buffer, size_t length, std::uint64_t offset) {
+	size_t done = 0;
+	while (done < length) {
+		size_t put = co_await this->write(fd, buffer + done, length - done, offset == CURRENT_POSITION ? offset : offset + done);
+		if (put == 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not write during async I/O.");
+		}
+		done += put;
+	}
+}
+
+
+///////////////////
+//Async encryption
+///////////////////
+
+ANGELITA128_Task<std::uint64_t> ANGELITA128::transformAsync(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, ANGELITA128_ChunkTransform transform, ANGELITA128_AsyncIO& io) const {
+	//The same chunks as ANGELITA128_BlockingIO, read a chunk ahead so the transform knows which is the last
+	//The offsets move on by what is read and written, unless they are CURRENT_POSITION; returns the bytes read
+	const std::uint64_t current = ANGELITA128_AsyncIO::CURRENT_POSITION;
+	size_t chunkSize = this->chunkSize;
+	std::vector<unsigned char> currentChunk(chunkSize + 16);
+	std::vector<unsigned char> nextChunk(chunkSize + 16);
+	std::uint64_t bytes = 0;
+	size_t currentLength = co_await io.readFull(inputFd, currentChunk.data(), chunkSize, inputOffset);
+	for (;;) {
+		inputOffset += inputOffset == current ? 0 : currentLength;
+		size_t nextLength = 0;
+		if (currentLength == chunkSize) {
+			nextLength = co_await io.readFull(inputFd, nextChunk.data(), chunkSize, inputOffset);
+		}
+		bool lastChunk = nextLength == 0;
+		bytes += currentLength;
+		size_t outputLength = transform(currentChunk.data(), currentLength, lastChunk);
+		co_await io.writeFull(outputFd, currentChunk.data(), outputLength, outputOffset);
+		outputOffset += outputOffset == current ? 0 : outputLength;
+		if (lastChunk) {
+			break;
+		}
+		std::swap(currentChunk, nextChunk);
+		currentLength = nextLength;
+	}
+	co_return bytes;
+}
+
+ANGELITA128_Task<void> ANGELITA128::encryptAsync(std::string file, std::string mode, std::array<unsigned char, 16> IV, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const {
+	//The key and mode are checked when called, like encrypt(), the rest runs in the task
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to encrypt.");
+	}
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid encrypt mode, must be \"ecb\" or \"cbc\".");
+	}
+	return this->encryptFileAsync(file, mode == "cbc", mode == "cbc" ? IV : std::array<unsigned char, 16>{}, io, resumeExecutor);
+}
+
+ANGELITA128_Task<void> ANGELITA128::decryptAsync(std::string file, std::string mode, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const {
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid decrypt mode, must be \"ecb\" or \"cbc\".");
+	}
+	return this->decryptFileAsync(file, mode == "cbc", io, resumeExecutor);
+}
+
+ANGELITA128_Task<void> ANGELITA128::encryptFileAsync(std::string file, bool cbc, std::array<unsigned char, 16> IV, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const {
+	//encryptFile with the reads and writes suspending; the opens happen on io's executor too, off the caller's loop
+	co_await io.cipherExecutor().schedule();
+	std::exception_ptr error;
+	std::string newFileName = file + ".ANGELITA128";
+	int inputFd = -1;
+	int outputFd = -1;
+	bool created = 0;
+	bool written = 0;
+	try {
+		inputFd = open(file.c_str(), O_RDONLY);
+		if (inputFd < 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and encrypt.");
+		}
+		struct stat inputStat;
+		fstat(inputFd, &inputStat);
+		outputFd = open(newFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+		if (outputFd < 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after encrypt.");
+		}
+		created = 1;
+
+		std::array<unsigned char, 16> chainBlock = IV;
+		std::uint64_t outputOffset = 0;
+		if (cbc) {
+			co_await io.writeFull(outputFd, IV.data(), 16, 0);
+			outputOffset = 16;
+		}
+		co_await this->transformAsync(inputFd, 0, outputFd, outputOffset, this->encryptTransform(cbc, chainBlock), io);
+		close(inputFd);
+		inputFd = -1;
+		int closed = close(outputFd);
+		outputFd = -1;
+		if (closed != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not write file after encrypt.");
+		}
+		written = 1;
+		if (unlink(file.c_str()) != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not remove the original file after encrypt.");
+		}
+	}
+	catch (...) {
+		error = std::current_exception();
+		if (inputFd >= 0) {
+			close(inputFd);
+		}
+		if (outputFd >= 0) {
+			close(outputFd);
+		}
+		if (created && !written) {
+			unlink(newFileName.c_str());
+		}
+	}
+	co_await resumeExecutor.schedule();
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+ANGELITA128_Task<void> ANGELITA128::decryptFileAsync(std::string file, bool cbc, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const {
+	//decryptFile with the reads and writes suspending
+	co_await io.cipherExecutor().schedule();
+	std::exception_ptr error;
+	std::string newFileName = std::regex_replace(file, std::regex("(\\.ANGELITA128)$"), "");
+	std::string outputName = newFileName == file ? file + ".ANGELITA128_decrypt" : newFileName;
+	int inputFd = -1;
+	int outputFd = -1;
+	bool created = 0;
+	bool written = 0;
+	try {
+		inputFd = open(file.c_str(), O_RDONLY);
+		if (inputFd < 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and decrypt.");
+		}
+		struct stat inputStat;
+		fstat(inputFd, &inputStat);
+		if (inputStat.st_size == 0 || inputStat.st_size % 16 != 0 || (cbc && inputStat.st_size < 32)) {
+			throw ANGELITA128_Exception("ANGELITA128: File size is not valid for decrypt, file is not encrypted in this mode.");
+		}
+		outputFd = open(outputName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+		if (outputFd < 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after decrypt.");
+		}
+		created = 1;
+
+		std::array<unsigned char, 16> chainBlock;
+		std::uint64_t inputOffset = 0;
+		if (cbc) {
+			if (co_await io.readFull(inputFd, chainBlock.data(), 16, 0) != 16) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not read during async I/O.");
+			}
+			inputOffset = 16;
+		}
+		co_await this->transformAsync(inputFd, inputOffset, outputFd, 0, this->decryptTransform(cbc, chainBlock), io);
+		close(inputFd);
+		inputFd = -1;
+		int closed = close(outputFd);
+		outputFd = -1;
+		if (closed != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not write file after decrypt.");
+		}
+		written = 1;
+		if (outputName != newFileName) {
+			if (std::rename(outputName.c_str(), newFileName.c_str()) != 0) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not rename file after decrypt.");
+			}
+		}
+		else if (unlink(file.c_str()) != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not remove the encrypted file after decrypt.");
+		}
+	}
+	catch (...) {
+		error = std::current_exception();
+		if (inputFd >= 0) {
+			close(inputFd);
+		}
+		if (outputFd >= 0) {
+			close(outputFd);
+		}
+		if (created && !written) {
+			unlink(outputName.c_str());
+		}
+	}
+	co_await resumeExecutor.schedule();
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+ANGELITA128_Task<std::uint64_t> ANGELITA128::encryptStreamAsync(int inputFd, int outputFd, std::string mode, std::array<unsigned char, 16> IV, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const {
+	//encryptStream as a task, reading and writing the descriptors from where they are, pipes included
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to encrypt.");
+	}
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid encrypt mode, must be \"ecb\" or \"cbc\".");
+	}
+	return this->streamAsync(inputFd, outputFd, mode == "cbc", 1, IV, io, resumeExecutor);
+}
+
+ANGELITA128_Task<std::uint64_t> ANGELITA128::decryptStreamAsync(int inputFd, int outputFd, std::string mode, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const {
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid decrypt mode, must be \"ecb\" or \"cbc\".");
+	}
+	return this->streamAsync(inputFd, outputFd, mode == "cbc", 0, {}, io, resumeExecutor);
+}
+
+ANGELITA128_Task<std::uint64_t> ANGELITA128::streamAsync(int inputFd, int outputFd, bool cbc, bool encrypting, std::array<unsigned char, 16> IV, ANGELITA128_AsyncIO& io, ANGELITA128_Executor& resumeExecutor) const {
+	co_await io.cipherExecutor().schedule();
+	const std::uint64_t current = ANGELITA128_AsyncIO::CURRENT_POSITION;
+	std::exception_ptr error;
+	std::uint64_t bytes = 0;
+	try {
+		std::array<unsigned char, 16> chainBlock = IV;
+		if (cbc && encrypting) {
+			co_await io.writeFull(outputFd, chainBlock.data(), 16, current);
+		}
+		else if (cbc) {
+			if (co_await io.readFull(inputFd, chainBlock.data(), 16, current) != 16) {
+				throw ANGELITA128_Exception("ANGELITA128: Input length is not valid for decrypt, input is not encrypted in this mode.");
+			}
+			bytes = 16;
+		}
+		ANGELITA128_ChunkTransform transform = encrypting ? this->encryptTransform(cbc, chainBlock) : this->decryptTransform(cbc, chainBlock);
+		bytes += co_await this->transformAsync(inputFd, current, outputFd, current, transform, io);
+	}
+	catch (...) {
+		error = std::current_exception();
+	}
+	co_await resumeExecutor.schedule();
+	if (error) {
+		std::rethrow_exception(error);
+	}
+	co_return bytes;
+}
+
+ANGELITA128_Task<size_t> ANGELITA128::encryptAsync(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV, ANGELITA128_Executor& cipherExecutor, ANGELITA128_Executor& resumeExecutor) const {
+	//The buffer interface on cipherExecutor, the buffers must stay put until the task is done
+	co_await cipherExecutor.schedule();
+	std::exception_ptr error;
+	size_t outputLength = 0;
+	try {
+		outputLength = this->encrypt(input, output, mode, IV);
+	}
+	catch (...) {
+		error = std::current_exception();
+	}
+	co_await resumeExecutor.schedule();
+	if (error) {
+		std::rethrow_exception(error);
+	}
+	co_return outputLength;
+}
+
+ANGELITA128_Task<size_t> ANGELITA128::decryptAsync(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV, ANGELITA128_Executor& cipherExecutor, ANGELITA128_Executor& resumeExecutor) const {
+	co_await cipherExecutor.schedule();
+	std::exception_ptr error;
+	size_t outputLength = 0;
+	try {
+		outputLength = this->decrypt(input, output, mode, IV);
+	}
+	catch (...) {
+		error = std::current_exception();
+	}
+	co_await resumeExecutor.schedule();
+	if (error) {
+		std::rethrow_exception(error);
+	}
+	co_return outputLength;
+}
@@ -0,0 +1,284 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 async interface header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 coroutine task, executor and async I/O classes
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+/*
+	Async interface for event loops, built on C++20 coroutines.
+
+	An ANGELITA128_Task<T> is lazy: it starts when a coroutine co_awaits it, or when get() blocks on it from outside one.
+	The operations suspend on every read and write, which ANGELITA128_AsyncIO runs on its own thread through io_uring
+	(or on a few blocking threads where io_uring isn't there), carry on with the cipher on the executor the AsyncIO was
+	made with, and finish on the executor the caller gives, so an event loop wraps its own queue in an ANGELITA128_Executor
+	and gets its coroutines back on the loop thread.
+
+	ANGELITA128_ThreadPoolExecutor pool(4);
+	ANGELITA128_AsyncIO io(pool);
+	co_await a1.encryptAsync("notes.txt", "cbc", IV, io, loop);
+*/
+
+#ifndef ANGELITA128_ASYNC_H
+#define ANGELITA128_ASYNC_H
+
+#include "ANGELITA128_IO.h"
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <semaphore>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <utility>
+
+class ANGELITA128_Executor;
+
+struct ANGELITA128_ScheduleAwaiter {
+	ANGELITA128_Executor* executor;
+	bool await_ready() const noexcept { return 0; }
+	void await_suspend(std::coroutine_handle<> waiting);
+	void await_resume() const noexcept {}
+};
+
+//Somewhere to run work: a thread pool, or an event loop's own queue
+class ANGELITA128_Executor {
+public:
+	virtual ~ANGELITA128_Executor() {}
+	virtual void post(std::function<void()> work) = 0;
+
+	//co_await executor.schedule() carries on on the executor
+	ANGELITA128_ScheduleAwaiter schedule() { return ANGELITA128_ScheduleAwaiter{ this }; }
+};
+
+inline void ANGELITA128_ScheduleAwaiter::await_suspend(std::coroutine_handle<> waiting) {
+	this->executor->post([waiting]() { waiting.resume(); });
+}
+
+class ANGELITA128_ThreadPoolExecutor : public ANGELITA128_Executor {
+private:
+	std::mutex lock;
+	std::condition_variable workReady;
+	std::deque<std::function<void()>> work;
+	std::vector<std::thread> threads;
+	bool stopping = 0;
+
+	void serve();
+
+public:
+	//threadCount 0 for one per core; work still queued when it is destroyed is run first
+	ANGELITA128_ThreadPoolExecutor(unsigned int threadCount = 0);
+	~ANGELITA128_ThreadPoolExecutor();
+	ANGELITA128_ThreadPoolExecutor(const ANGELITA128_ThreadPoolExecutor&) = delete;
+	ANGELITA128_ThreadPoolExecutor& operator=(const ANGELITA128_ThreadPoolExecutor&) = delete;
+
+	void post(std::function<void()> work) override;
+};
+
+//Where a task keeps its result, co_return value for a value and plain co_return for void
+template <typename T>
+struct ANGELITA128_TaskResult {
+	std::optional<T> value;
+	void return_value(T result) { this->value.emplace(std::move(result)); }
+	T take() { return std::move(*this->value); }
+};
+
+template <>
+struct ANGELITA128_TaskResult<void> {
+	void return_void() {}
+	void take() {}
+};
+
+template <typename T>
+class ANGELITA128_Task {
+public:
+	struct promise_type : ANGELITA128_TaskResult<T> {
+		std::coroutine_handle<> continuation;
+		std::exception_ptr error;
+
+		struct FinalAwaiter {
+			bool await_ready() const noexcept { return 0; }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> finished) noexcept {
+				//Hand straight on to whoever awaited the task, without growing the stack
+				std::coroutine_handle<> continuation = finished.promise().continuation;
+				return continuation ? continuation : std::noop_coroutine();
+			}
+			void await_resume() const noexcept {}
+		};
+
+		ANGELITA128_Task get_return_object() { return ANGELITA128_Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() const noexcept { return {}; }
+		FinalAwaiter final_suspend() const noexcept { return {}; }
+		void unhandled_exception() { this->error = std::current_exception(); }
+	};
+
+private:
+	std::coroutine_handle<promise_type> handle;
+
+	explicit ANGELITA128_Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+	//A coroutine for get() to start the task from, which signals when the task has finished
+	struct Waiter {
+		struct promise_type {
+			std::binary_semaphore* finished = nullptr;
+			Waiter get_return_object() { return Waiter{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			auto final_suspend() const noexcept {
+				struct Signal {
+					bool await_ready() const noexcept { return 0; }
+					void await_suspend(std::coroutine_handle<promise_type> done) noexcept { done.promise().finished->release(); }
+					void await_resume() const noexcept {}
+				};
+				return Signal{};
+			}
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	struct Start {
+		std::coroutine_handle<promise_type> task;
+		bool await_ready() const noexcept { return 0; }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiting) noexcept {
+			this->task.promise().continuation = waiting;
+			return this->task;
+		}
+		void await_resume() const noexcept {}
+	};
+
+	static Waiter wait(std::coroutine_handle<promise_type> task) {
+		co_await Start{ task };
+	}
+
+public:
+	ANGELITA128_Task(ANGELITA128_Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+	ANGELITA128_Task& operator=(ANGELITA128_Task&& other) noexcept {
+		if (this != &other) {
+			if (this->handle) {
+				this->handle.destroy();
+			}
+			this->handle = std::exchange(other.handle, {});
+		}
+		return *this;
+	}
+	~ANGELITA128_Task() {
+		if (this->handle) {
+			this->handle.destroy();
+		}
+	}
+
+	//Awaiting a task starts it, and the awaiting coroutine resumes when it is done with its result or its exception
+	bool await_ready() const noexcept { return 0; }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiting) noexcept {
+		this->handle.promise().continuation = waiting;
+		return this->handle;
+	}
+	T await_resume() {
+		if (this->handle.promise().error) {
+			std::rethrow_exception(this->handle.promise().error);
+		}
+		return this->handle.promise().take();
+	}
+
+	//Run the task and block until it is done, for callers that aren't coroutines; not from an executor the task needs
+	T get() {
+		std::binary_semaphore finished(0);
+		Waiter waiter = wait(this->handle);
+		waiter.handle.promise().finished = &finished;
+		waiter.handle.resume();
+		finished.acquire();
+		waiter.handle.destroy();
+		return this->await_resume();
+	}
+};
+
+//Reads and writes that suspend the coroutine awaiting them instead of blocking its thread
+//It resumes on executor once the operation is done
+class ANGELITA128_AsyncIO {
+public:
+	//The offset for reads and writes at the descriptor's own position, for pipes
+	static const std::uint64_t CURRENT_POSITION = ~(std::uint64_t)0;
+
+	struct Request {
+		ANGELITA128_AsyncIO* io;
+		int fd;
+		bool writing;
+		unsigned char* buffer;
+		size_t length;
+		std::uint64_t offset;
+		long long result = 0;
+		std::coroutine_handle<> waiting;
+
+		bool await_ready() const noexcept { return 0; }
+		void await_suspend(std::coroutine_handle<> waiting);
+		//Returns the bytes read or written, which may be short; throws on an error
+		size_t await_resume() const;
+	};
+
+private:
+	ANGELITA128_Executor& executor;
+	unsigned int queueDepth;
+	std::mutex lock;
+	std::condition_variable requestsReady;
+	std::deque<Request*> requests;
+	std::vector<std::thread> threads;
+	bool stopping = 0;
+#ifdef ANGELITA128_IO_URING
+	std::unique_ptr<ANGELITA128_UringIO> ring;
+	int wakeFd = -1;
+	std::uint64_t wakeCount = 0;
+	void serveRing();
+#endif
+	void serveBlocking();
+	void finish(Request* request, long long result);
+
+public:
+	//backend "io_uring", "blocking" (queueDepth threads each making one blocking call at a time),
+	//or "auto" for io_uring where the kernel allows it; up to queueDepth operations are in flight at once
+	ANGELITA128_AsyncIO(ANGELITA128_Executor& executor, std::string backend = "auto", unsigned int queueDepth = 8);
+	~ANGELITA128_AsyncIO();
+	ANGELITA128_AsyncIO(const ANGELITA128_AsyncIO&) = delete;
+	ANGELITA128_AsyncIO& operator=(const ANGELITA128_AsyncIO&) = delete;
+
+	std::string name() const;
+	ANGELITA128_Executor& cipherExecutor() { return this->executor; }
+
+	//co_await io.read(...) for one read or write; readFull and writeFull carry on over short ones,
+	//readFull returns less than length only at the end of the input
+	Request read(int fd, unsigned char* buffer, size_t length, std::uint64_t offset);
+	Request write(int fd, const unsigned char* buffer, size_t length, std::uint64_t offset);
+	ANGELITA128_Task<size_t> readFull(int fd, unsigned char* buffer, size_t length, std::uint64_t offset);
+	ANGELITA128_Task<void> writeFull(int fd, const unsigned char* buffer, size_t length, std::uint64_t offset);
+};
+
+#endif
@@ -0,0 +1,259 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 authenticated mode methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 authenticated mode methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include <cstring>
+#include <mutex>
+
+//The authenticated mode is counter mode plus a PMAC over the ciphertext (encrypt then MAC):
+//	S = E(nonce)
+//	C[i] = P[i] ^ E(S + 1 + i)
+//	sum = E(C[1] ^ O[1]) ^ ... ^ E(C[m-1] ^ O[m-1]) ^ last
+//	tag = E(sum) ^ E(S)
+//Counting from E(nonce) instead of the nonce keeps nearby nonces (a counter, say) apart: the counter blocks and tag
+//mask of two messages only meet if their starts land within a message length of each other, as with random IVs.
+//where O[i] is the XOR of L[k] for each bit k set in the Gray code of i, so any block's offset is known
+//without the ones before it and the sum can be split over threads. The last block is not put through E:
+//a whole one is XORed with L$, a partial or empty one is padded with 0x80 and zeros and XORed with L*.
+//Each lane group is encrypted and then hashed while it is still in cache, so the data is only read once.
+
+//Blocks handled per thread at a time
+static const size_t AUTH_SEGMENT_BLOCKS = 4096;
+
+static void doubleBlock(std::array<unsigned char, 16>& block) {
+	//Multiply by x in GF(2^128), big endian, x^128 = x^7 + x^2 + x + 1
+	unsigned char carry = block[0] >> 7;
+	for (unsigned int i = 0; i < 15; i++) {
+		block[i] = (block[i] << 1) | (block[i + 1] >> 7);
+	}
+	block[15] = (block[15] << 1) ^ (carry * 0x87);
+}
+
+void ANGELITA128::genAuthTables() {
+	//Precompute the authenticated mode offsets at key setup
+	this->authLStar = {};
+	this->encryptLanes(this->authLStar.data(), 1);
+	this->authLDollar = this->authLStar;
+	doubleBlock(this->authLDollar);
+	std::array<unsigned char, 16> offset = this->authLDollar;
+	for (unsigned int i = 0; i < 64; i++) {
+		doubleBlock(offset);
+		this->authL[i] = offset;
+	}
+}
+
+void ANGELITA128::authBlocks(const unsigned char* input, unsigned char* output, size_t firstBlock, size_t blockCount, size_t hashedBlocks, std::array<unsigned char, 16> counterBlock, bool encrypting, std::array<unsigned char, 16>& sum) const {
+	//Work on whole blocks firstBlock to firstBlock + blockCount - 1 of the message (numbered from 0)
+	//encrypting: counter mode input into output, then hash the ciphertext; otherwise only hash input
+	//Blocks from hashedBlocks on are left out of the hash, the last block is added by authTag
+	//counterBlock is the counter for firstBlock, sum is XORed with this part of the hash
+	std::array<unsigned char, 16> offset = {};
+	std::uint64_t gray = firstBlock ^ (firstBlock >> 1);
+	for (unsigned int k = 0; k < 64; k++) {
+		if ((gray >> k) & 1) {
+			for (unsigned int i = 0; i < 16; i++) {
+				offset[i] ^= this->authL[k][i];
+			}
+		}
+	}
+
+	unsigned char laneBlocks[256];
+	size_t block = firstBlock;
+	size_t endBlock = firstBlock + blockCount;
+	while (block < endBlock) {
+		unsigned int lanes = endBlock - block < this->laneCount ? endBlock - block : this->laneCount;
+		const unsigned char* ciphertext = input;
+		if (encrypting) {
+			for (unsigned int lane = 0; lane < lanes; lane++) {
+				std::memcpy(laneBlocks + lane * 16, counterBlock.data(), 16);
+				counterAdd(counterBlock, 1);
+			}
+			this->encryptLanes(laneBlocks, lanes);
+			for (unsigned int i = 0; i < lanes * 16; i++) {
+				output[i] = input[i] ^ laneBlocks[i];
+			}
+			ciphertext = output;
+		}
+
+		//Block n (from 0) takes the offset for n + 1, which is one L more than the offset for n
+		unsigned int hashLanes = 0;
+		for (unsigned int lane = 0; lane < lanes && block + lane < hashedBlocks; lane++, hashLanes++) {
+			std::uint64_t n = block + lane + 1;
+			unsigned int k = 0;
+			while (((n >> k) & 1) == 0) {
+				k++;
+			}
+			for (unsigned int i = 0; i < 16; i++) {
+				offset[i] ^= this->authL[k][i];
+				laneBlocks[lane * 16 + i] = ciphertext[lane * 16 + i] ^ offset[i];
+			}
+		}
+		this->encryptLanes(laneBlocks, hashLanes);
+		for (unsigned int lane = 0; lane < hashLanes; lane++) {
+			for (unsigned int i = 0; i < 16; i++) {
+				sum[i] ^= laneBlocks[lane * 16 + i];
+			}
+		}
+
+		input += lanes * 16;
+		output += lanes * 16;
+		block += lanes;
+	}
+}
+
+std::array<unsigned char, 16> ANGELITA128::authStart(const std::array<unsigned char, 16>& nonce) const {
+	//The message's counter block 0, E(nonce); block 0 masks the tag and the data starts at block 1
+	std::array<unsigned char, 16> startBlock = nonce;
+	this->encryptLanes(startBlock.data(), 1);
+	return startBlock;
+}
+
+void ANGELITA128::authTag(const unsigned char* ciphertext, size_t length, const std::array<unsigned char, 16>& startBlock, std::array<unsigned char, 16>& sum) const {
+	//Add the last block to the hash and turn it into the tag, in place
+	size_t lastLength = length % 16;
+	if (length > 0 && lastLength == 0) {
+		lastLength = 16;
+	}
+	const unsigned char* last = ciphertext + length - lastLength;
+	const std::array<unsigned char, 16>& offset = lastLength == 16 ? this->authLDollar : this->authLStar;
+	for (unsigned int i = 0; i < 16; i++) {
+		sum[i] ^= offset[i];
+	}
+	for (unsigned int i = 0; i < lastLength; i++) {
+		sum[i] ^= last[i];
+	}
+	if (lastLength < 16) {
+		sum[lastLength] ^= 0x80;
+	}
+
+	unsigned char laneBlocks[32];
+	std::memcpy(laneBlocks, sum.data(), 16);
+	std::memcpy(laneBlocks + 16, startBlock.data(), 16);
+	this->encryptLanes(laneBlocks, 2);
+	for (unsigned int i = 0; i < 16; i++) {
+		sum[i] = laneBlocks[i] ^ laneBlocks[16 + i];
+	}
+}
+
+void ANGELITA128::encryptAuthenticated(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, const std::array<unsigned char, 16>& nonce, std::array<unsigned char, 16>& tag, unsigned int threadCount) const {
+	//Encrypt input into output and make the tag in one pass
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to encrypt.");
+	}
+	if (output.size() < input.size()) {
+		throw ANGELITA128_Exception("ANGELITA128: Output buffer is too small to encrypt into.");
+	}
+	size_t length = input.size();
+	size_t wholeBlocks = length / 16;
+	size_t hashedBlocks = length % 16 == 0 && wholeBlocks > 0 ? wholeBlocks - 1 : wholeBlocks;
+	std::array<unsigned char, 16> startBlock = this->authStart(nonce);
+	std::array<unsigned char, 16> counterBlock = startBlock;
+	counterAdd(counterBlock, 1);
+
+	std::array<unsigned char, 16> sum = {};
+	std::mutex sumLock;
+	size_t segments = (wholeBlocks + AUTH_SEGMENT_BLOCKS - 1) / AUTH_SEGMENT_BLOCKS;
+	parallelFor(segments, resolveThreadCount(threadCount), [&](size_t segment) {
+		size_t firstBlock = segment * AUTH_SEGMENT_BLOCKS;
+		size_t blockCount = wholeBlocks - firstBlock < AUTH_SEGMENT_BLOCKS ? wholeBlocks - firstBlock : AUTH_SEGMENT_BLOCKS;
+		std::array<unsigned char, 16> segmentCounter = counterBlock;
+		counterAdd(segmentCounter, firstBlock);
+		std::array<unsigned char, 16> segmentSum = {};
+		this->authBlocks(input.data() + firstBlock * 16, output.data() + firstBlock * 16, firstBlock, blockCount, hashedBlocks, segmentCounter, 1, segmentSum);
+		std::lock_guard<std::mutex> guard(sumLock);
+		for (unsigned int i = 0; i < 16; i++) {
+			sum[i] ^= segmentSum[i];
+		}
+	});
+
+	//The partial last block
+	if (length % 16 != 0) {
+		counterAdd(counterBlock, wholeBlocks);
+		this->encryptCTR(input.data() + wholeBlocks * 16, output.data() + wholeBlocks * 16, length % 16, counterBlock);
+	}
+	this->authTag(output.data(), length, startBlock, sum);
+	tag = sum;
+}
+
+void ANGELITA128::decryptAuthenticated(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, const std::array<unsigned char, 16>& nonce, const std::array<unsigned char, 16>& tag, unsigned int threadCount) const {
+	//Check the tag over the ciphertext, then decrypt input into output
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	if (output.size() < input.size()) {
+		throw ANGELITA128_Exception("ANGELITA128: Output buffer is too small to decrypt into.");
+	}
+	size_t length = input.size();
+	size_t wholeBlocks = length / 16;
+	size_t hashedBlocks = length % 16 == 0 && wholeBlocks > 0 ? wholeBlocks - 1 : wholeBlocks;
+	std::array<unsigned char, 16> startBlock = this->authStart(nonce);
+	std::array<unsigned char, 16> counterBlock = startBlock;
+	counterAdd(counterBlock, 1);
+	unsigned int threads = resolveThreadCount(threadCount);
+
+	std::array<unsigned char, 16> sum = {};
+	std::mutex sumLock;
+	size_t segments = (hashedBlocks + AUTH_SEGMENT_BLOCKS - 1) / AUTH_SEGMENT_BLOCKS;
+	parallelFor(segments, threads, [&](size_t segment) {
+		size_t firstBlock = segment * AUTH_SEGMENT_BLOCKS;
+		size_t blockCount = hashedBlocks - firstBlock < AUTH_SEGMENT_BLOCKS ? hashedBlocks - firstBlock : AUTH_SEGMENT_BLOCKS;
+		std::array<unsigned char, 16> segmentSum = {};
+		this->authBlocks(input.data() + firstBlock * 16, nullptr, firstBlock, blockCount, hashedBlocks, counterBlock, 0, segmentSum);
+		std::lock_guard<std::mutex> guard(sumLock);
+		for (unsigned int i = 0; i < 16; i++) {
+			sum[i] ^= segmentSum[i];
+		}
+	});
+	this->authTag(input.data(), length, startBlock, sum);
+
+	//Compare every byte, so the time taken doesn't show how much of the tag matched
+	unsigned char difference = 0;
+	for (unsigned int i = 0; i < 16; i++) {
+		difference |= sum[i] ^ tag[i];
+	}
+	if (difference != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Authentication failed, the data or tag was changed or the key or nonce is wrong.");
+	}
+
+	size_t segmentBytes = AUTH_SEGMENT_BLOCKS * 16;
+	parallelFor((length + segmentBytes - 1) / segmentBytes, threads, [&](size_t segment) {
+		size_t start = segment * segmentBytes;
+		size_t bytes = length - start < segmentBytes ? length - start : segmentBytes;
+		std::array<unsigned char, 16> segmentCounter = counterBlock;
+		counterAdd(segmentCounter, start / 16);
+		this->decryptCTR(input.data() + start, output.data() + start, bytes, segmentCounter);
+	});
+}
@@ -0,0 +1,330 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 batch methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 batch methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include "ANGELITA128_Scheduler.h"
+#include "ANGELITA128_Arena.h"
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+//Files below this size are encrypted in groups through encryptCBCMulti in cbc mode
+static const std::uintmax_t SMALL_FILE_SIZE = 65536;
+
+double ANGELITA128_BatchReport::throughput() const {
+	//Aggregate throughput of the finished files in MB/s
+	if (this->seconds <= 0) {
+		return 0;
+	}
+	return ((double)this->totalBytes / 1000000.0) / this->seconds;
+}
+
+void ANGELITA128_BatchReport::showReport() const {
+	//Output the per file failures and the aggregate figures to the console
+	for (unsigned int i = 0; i < this->results.size(); i++) {
+		if (this->results[i].failed) {
+			std::cout << "Failed: " << this->results[i].file << ": " << this->results[i].errorMessage << "\n";
+		}
+	}
+
+	std::ios oldState(nullptr);
+	oldState.copyfmt(std::cout);
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "Files: " << this->results.size() << ", failed: " << this->failures << ", threads: " << this->threadCount << "\n";
+	std::cout << "Bytes: " << this->totalBytes << " in " << this->seconds << "s, " << this->throughput() << " MB/s\n";
+	std::cout.copyfmt(oldState);
+}
+
+static void recordFailure(ANGELITA128_BatchResult& result) {
+	//Store the error of the exception being handled against the file
+	result.failed = 1;
+	try {
+		throw;
+	}
+	catch (ANGELITA128_Exception& err) {
+		result.errorMessage = err.what();
+	}
+	catch (std::exception& err) {
+		result.errorMessage = std::string("ANGELITA128: ") + err.what();
+	}
+}
+
+void ANGELITA128::encryptSmallFiles(std::vector<std::string>& files, std::vector<std::array<unsigned char, 16>>& IVs, std::vector<ANGELITA128_BatchResult>& results, std::vector<unsigned int> group) const {
+	//Encrypt a group of small files in cbc mode with one pass of encryptCBCMulti
+	//Each file is read whole into its slot of one arena buffer, laid out as the output file, IV then blocks.
+	//Every group asks for the same size, so each thread keeps reusing one buffer
+	size_t slotSize = 16 + SMALL_FILE_SIZE;
+	ANGELITA128_ArenaBuffer buffer(slotSize * group.size());
+	std::vector<size_t> sizes(group.size());
+	std::vector<ANGELITA128_CBCJob> jobs;
+	std::vector<unsigned int> jobFiles;
+	std::vector<mode_t> fileModes;
+	for (unsigned int k = 0; k < group.size(); k++) {
+		unsigned int i = group[k];
+		int fd = -1;
+		try {
+			fd = open(files[i].c_str(), O_RDONLY);
+			if (fd < 0) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and encrypt.");
+			}
+			struct stat fileStat;
+			fstat(fd, &fileStat);
+			size_t size = fileStat.st_size;
+			if (size >= SMALL_FILE_SIZE) {
+				throw ANGELITA128_Exception("ANGELITA128: File changed size during batch encrypt.");
+			}
+			unsigned int paddingSize = 16 - (size % 16);
+			unsigned char* slot = buffer.data() + k * slotSize;
+			std::memcpy(slot, IVs[i].data(), 16);
+			ANGELITA128_IO::readAt(fd, slot + 16, size, 0);
+			std::memset(slot + 16 + size, paddingSize, paddingSize);
+			close(fd);
+			sizes[k] = 16 + size + paddingSize;
+
+			ANGELITA128_CBCJob job;
+			job.input = slot + 16;
+			job.output = slot + 16;
+			job.blockCount = (size + paddingSize) / 16;
+			job.chainBlock = IVs[i];
+			jobs.push_back(job);
+			jobFiles.push_back(k);
+			fileModes.push_back(fileStat.st_mode & 0777);
+		}
+		catch (...) {
+			if (fd >= 0) {
+				close(fd);
+			}
+			recordFailure(results[i]);
+		}
+	}
+
+	this->encryptCBCMulti(jobs);
+
+	for (unsigned int j = 0; j < jobFiles.size(); j++) {
+		unsigned int k = jobFiles[j];
+		unsigned int i = group[k];
+		std::string newFileName = files[i] + ".ANGELITA128";
+		int fd = open(newFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, fileModes[j]);
+		try {
+			if (fd < 0) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after encrypt.");
+			}
+			ANGELITA128_IO::writeAt(fd, buffer.data() + k * slotSize, sizes[k], 0);
+			if (close(fd) != 0) {
+				fd = -1;
+				throw ANGELITA128_Exception("ANGELITA128: Could not write file after encrypt.");
+			}
+			fd = -1;
+			if (unlink(files[i].c_str()) != 0) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not remove the original file after encrypt.");
+			}
+		}
+		catch (...) {
+			if (fd >= 0) {
+				close(fd);
+				unlink(newFileName.c_str());
+			}
+			recordFailure(results[i]);
+		}
+	}
+}
+
+ANGELITA128_BatchReport ANGELITA128::runBatch(std::vector<std::string> files, std::string mode, bool encrypting, unsigned int threadCount) {
+	//Encrypt or decrypt every file on a pool of worker threads that share this keyed object
+	//One file failing is recorded in the report, the rest of the batch still runs
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set for batch encrypt or decrypt.");
+	}
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid batch mode, must be \"ecb\" or \"cbc\".");
+	}
+
+	ANGELITA128_BatchReport report;
+	report.results.resize(files.size());
+	for (unsigned int i = 0; i < files.size(); i++) {
+		std::error_code err;
+		report.results[i].file = files[i];
+		report.results[i].bytes = std::filesystem::file_size(files[i], err);
+		if (err) {
+			report.results[i].bytes = 0;
+		}
+	}
+
+	//Largest files go first, so a big file is never the last one started
+	//while the other workers sit idle; the small files fill in around it
+	std::vector<unsigned int> order(files.size());
+	for (unsigned int i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&report](unsigned int a, unsigned int b) {
+		return report.results[a].bytes > report.results[b].bytes;
+	});
+
+	//GLORIA borrows the S-Box and P-Box, so all the IVs are made before the workers start
+	std::vector<std::array<unsigned char, 16>> IVs(files.size());
+	if (encrypting && mode == "cbc") {
+		for (unsigned int i = 0; i < IVs.size(); i++) {
+			IVs[i] = this->GLORIA();
+		}
+	}
+	if (!encrypting && !this->reverseSet) {
+		this->genRevSbox();
+		this->genRevPbox();
+		this->reverseSet = 1;
+	}
+
+	//Each work item is one file, or in cbc encryption a group of small files
+	//that go through the lanes together, since one cbc stream only fills one lane
+	std::vector<std::vector<unsigned int>> items;
+	std::vector<unsigned int> smallGroup;
+	for (unsigned int n = 0; n < order.size(); n++) {
+		unsigned int i = order[n];
+		if (encrypting && mode == "cbc" && report.results[i].bytes < SMALL_FILE_SIZE) {
+			smallGroup.push_back(i);
+			if (smallGroup.size() == this->laneCount) {
+				items.push_back(smallGroup);
+				smallGroup.clear();
+			}
+		}
+		else {
+			items.push_back(std::vector<unsigned int>(1, i));
+		}
+	}
+	if (!smallGroup.empty()) {
+		items.push_back(smallGroup);
+	}
+
+	threadCount = resolveThreadCount(threadCount);
+	if (threadCount > items.size()) {
+		threadCount = items.size();
+	}
+	if (threadCount == 0) {
+		threadCount = 1;
+	}
+	report.threadCount = threadCount;
+
+	//The items go over the shared scheduler one at a time, so a thread left with a big file
+	//has the small files queued behind it taken by the others
+	auto start = std::chrono::steady_clock::now();
+	ANGELITA128_Scheduler::shared().forEach(items.size(), threadCount, [&](size_t n) {
+		if (items[n].size() > 1) {
+			this->encryptSmallFiles(files, IVs, report.results, items[n]);
+			return;
+		}
+		unsigned int i = items[n][0];
+		try {
+			if (encrypting) {
+				this->encryptFile(files[i], mode, IVs[i]);
+			}
+			else {
+				this->decryptFile(files[i], mode);
+			}
+		}
+		catch (...) {
+			recordFailure(report.results[i]);
+		}
+	});
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (unsigned int i = 0; i < report.results.size(); i++) {
+		if (report.results[i].failed) {
+			report.failures++;
+		}
+		else {
+			report.totalBytes += report.results[i].bytes;
+		}
+	}
+	return report;
+}
+
+static std::vector<std::string> listDirectory(std::string directory, bool encrypted) {
+	//Recursively list the regular files in a directory
+	//encrypted picks the files with or without the ".ANGELITA128" extension
+	std::error_code err;
+	if (!std::filesystem::is_directory(directory, err)) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open directory for batch encrypt or decrypt.");
+	}
+
+	std::vector<std::string> files;
+	std::string extension = ".ANGELITA128";
+	for (auto it = std::filesystem::recursive_directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, err);
+		it != std::filesystem::recursive_directory_iterator(); it.increment(err)) {
+		if (err) {
+			break;
+		}
+		if (!it->is_regular_file(err)) {
+			continue;
+		}
+		std::string name = it->path().string();
+		bool hasExtension = name.size() >= extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0;
+		if (hasExtension == encrypted) {
+			files.push_back(name);
+		}
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+
+///////////////////
+//Batch interface
+///////////////////
+
+ANGELITA128_BatchReport ANGELITA128::encryptBatch(std::vector<std::string> files, std::string mode, unsigned int threadCount) {
+	//Encrypt a list of files, threadCount 0 uses one thread per core
+	return this->runBatch(files, mode, 1, threadCount);
+}
+
+ANGELITA128_BatchReport ANGELITA128::decryptBatch(std::vector<std::string> files, std::string mode, unsigned int threadCount) {
+	//Decrypt a list of ".ANGELITA128" files, threadCount 0 uses one thread per core
+	return this->runBatch(files, mode, 0, threadCount);
+}
+
+ANGELITA128_BatchReport ANGELITA128::encryptDirectory(std::string directory, std::string mode, unsigned int threadCount) {
+	//Encrypt every file under the directory that is not already encrypted
+	return this->runBatch(listDirectory(directory, 0), mode, 1, threadCount);
+}
+
+ANGELITA128_BatchReport ANGELITA128::decryptDirectory(std::string directory, std::string mode, unsigned int threadCount) {
+	//Decrypt every ".ANGELITA128" file under the directory
+	return this->runBatch(listDirectory(directory, 1), mode, 0, threadCount);
+}
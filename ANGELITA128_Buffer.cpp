@@ -0,0 +1,342 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 buffer methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 buffer methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include <cstring>
+
+static bool keepsLength(ANGELITA128_Mode mode) {
+	return mode == ANGELITA128_Mode::CTR || mode == ANGELITA128_Mode::ECB_CTS || mode == ANGELITA128_Mode::CBC_CTS;
+}
+
+static bool stealsCiphertext(ANGELITA128_Mode mode) {
+	return mode == ANGELITA128_Mode::ECB_CTS || mode == ANGELITA128_Mode::CBC_CTS;
+}
+
+static bool missingIV(ANGELITA128_Mode mode, const std::array<unsigned char, 16>& IV) {
+	//An all-zero IV is what a forgotten one looks like, and in ctr it would give the same keystream every time
+	return mode != ANGELITA128_Mode::ECB && mode != ANGELITA128_Mode::ECB_CTS && IV == std::array<unsigned char, 16>{};
+}
+
+size_t ANGELITA128::encryptedSize(size_t plaintextLength, ANGELITA128_Mode mode) {
+	//Output bytes needed to encrypt plaintextLength bytes
+	if (keepsLength(mode)) {
+		return plaintextLength;
+	}
+	return plaintextLength + 16 - (plaintextLength % 16);
+}
+
+size_t ANGELITA128::encrypt(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) const {
+	//Encrypt input into output, returns the bytes written, which is encryptedSize(input.size(), mode)
+	//The blocks are worked on in the output buffer, so nothing is allocated
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to encrypt.");
+	}
+	if (missingIV(mode, IV)) {
+		throw ANGELITA128_Exception("ANGELITA128: IV must be set to encrypt in this mode, an all-zero IV is refused.");
+	}
+	size_t outputLength = encryptedSize(input.size(), mode);
+	if (output.size() < outputLength) {
+		throw ANGELITA128_Exception("ANGELITA128: Output buffer is too small to encrypt into.");
+	}
+	if (mode == ANGELITA128_Mode::CTR) {
+		this->encryptCTR(input.data(), output.data(), input.size(), IV);
+		return outputLength;
+	}
+	if (stealsCiphertext(mode)) {
+		if (input.size() < 16) {
+			throw ANGELITA128_Exception("ANGELITA128: Input must be at least 16 bytes for ciphertext stealing.");
+		}
+		if (output.data() != input.data()) {
+			std::memmove(output.data(), input.data(), input.size());
+		}
+		this->encryptStealing(output.data(), input.size(), mode == ANGELITA128_Mode::CBC_CTS, IV);
+		return outputLength;
+	}
+
+	//Use padding to make 16n blocks even, an empty input is one block of padding
+	if (input.size() > 0 && output.data() != input.data()) {
+		std::memmove(output.data(), input.data(), input.size());
+	}
+	unsigned int paddingSize = outputLength - input.size();
+	std::memset(output.data() + input.size(), paddingSize, paddingSize);
+	if (mode == ANGELITA128_Mode::CBC) {
+		this->encryptCBC(output.data(), output.data(), outputLength / 16, IV);
+	}
+	else {
+		this->encryptECB(output.data(), output.data(), outputLength / 16);
+	}
+	return outputLength;
+}
+
+size_t ANGELITA128::decrypt(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) const {
+	//Decrypt input into output, returns the plaintext length
+	//The padding is only known after decrypting, so output needs room for input.size() bytes
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	if (output.size() < input.size()) {
+		throw ANGELITA128_Exception("ANGELITA128: Output buffer is too small to decrypt into.");
+	}
+	if (mode == ANGELITA128_Mode::CTR) {
+		this->decryptCTR(input.data(), output.data(), input.size(), IV);
+		return input.size();
+	}
+	if (stealsCiphertext(mode)) {
+		if (input.size() < 16) {
+			throw ANGELITA128_Exception("ANGELITA128: Input must be at least 16 bytes for ciphertext stealing.");
+		}
+		if (output.data() != input.data()) {
+			std::memmove(output.data(), input.data(), input.size());
+		}
+		this->decryptStealing(output.data(), input.size(), mode == ANGELITA128_Mode::CBC_CTS, IV);
+		return input.size();
+	}
+	if (input.size() == 0 || input.size() % 16 != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Input length is not valid for decrypt, must be a multiple of 16 bytes.");
+	}
+	if (mode == ANGELITA128_Mode::CBC) {
+		this->decryptCBC(input.data(), output.data(), input.size() / 16, IV);
+	}
+	else {
+		this->decryptECB(input.data(), output.data(), input.size() / 16);
+	}
+
+	//Get the padding size and leave it off the plaintext length
+	unsigned int paddingSize = output[input.size() - 1];
+	if (paddingSize == 0 || paddingSize > 16) {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid padding after decrypt, wrong key or mode.");
+	}
+	return input.size() - paddingSize;
+}
+
+void ANGELITA128::encryptStealing(unsigned char* data, size_t length, bool cbc, std::array<unsigned char, 16> chainBlock) const {
+	//Encrypt length >= 16 bytes in place with ciphertext stealing, chainBlock is the IV for cbc
+	//With a partial last block P[n] of r bytes and X the encryption of the last whole block P[n-1]:
+	//ecb: Y = E(P[n] | the last 16 - r bytes of X)
+	//cbc: Y = E((P[n] padded with zeros) ^ X)
+	//and the output ends with Y then the first r bytes of X, the rest of X is carried in Y
+	size_t wholeBlocks = length / 16;
+	size_t r = length % 16;
+	if (cbc) {
+		this->encryptCBC(data, data, wholeBlocks, chainBlock);
+	}
+	else {
+		this->encryptECB(data, data, wholeBlocks);
+	}
+	if (r == 0) {
+		return;
+	}
+
+	unsigned char* lastWhole = data + (wholeBlocks - 1) * 16;
+	unsigned char* tail = data + wholeBlocks * 16;
+	std::array<unsigned char, 16> stolen;
+	std::memcpy(stolen.data(), tail, r);
+	if (cbc) {
+		std::memset(stolen.data() + r, 0, 16 - r);
+		this->encryptCBC(stolen.data(), stolen.data(), 1, chainBlock);
+	}
+	else {
+		std::memcpy(stolen.data() + r, lastWhole + r, 16 - r);
+		this->encryptECB(stolen.data(), stolen.data(), 1);
+	}
+	std::memcpy(tail, lastWhole, r);
+	std::memcpy(lastWhole, stolen.data(), 16);
+}
+
+void ANGELITA128::decryptStealing(unsigned char* data, size_t length, bool cbc, std::array<unsigned char, 16> chainBlock) const {
+	//Decrypt length >= 16 bytes in place with ciphertext stealing, the reverse of encryptStealing
+	size_t wholeBlocks = length / 16;
+	size_t r = length % 16;
+	if (r == 0) {
+		if (cbc) {
+			this->decryptCBC(data, data, wholeBlocks, chainBlock);
+		}
+		else {
+			this->decryptECB(data, data, wholeBlocks);
+		}
+		return;
+	}
+
+	//The blocks before Y are as usual, leaving chainBlock as the one before X
+	if (cbc) {
+		this->decryptCBC(data, data, wholeBlocks - 1, chainBlock);
+	}
+	else {
+		this->decryptECB(data, data, wholeBlocks - 1);
+	}
+	unsigned char* lastWhole = data + (wholeBlocks - 1) * 16;
+	unsigned char* tail = data + wholeBlocks * 16;
+
+	//Decrypting Y gives back the bytes of X that were not output
+	std::array<unsigned char, 16> stolen;
+	this->decryptECB(lastWhole, stolen.data(), 1);
+	std::array<unsigned char, 16> lastX;
+	std::memcpy(lastX.data(), tail, r);
+	std::memcpy(lastX.data() + r, stolen.data() + r, 16 - r);
+	for (unsigned int i = 0; i < r; i++) {
+		tail[i] = cbc ? stolen[i] ^ lastX[i] : stolen[i];
+	}
+	if (cbc) {
+		this->decryptCBC(lastX.data(), lastWhole, 1, chainBlock);
+	}
+	else {
+		this->decryptECB(lastX.data(), lastWhole, 1);
+	}
+}
+
+size_t ANGELITA128::encryptInPlace(std::span<std::uint8_t> buffer, size_t plaintextLength, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) const {
+	//Encrypt the first plaintextLength bytes of buffer over themselves, buffer needs encryptedSize() bytes
+	if (plaintextLength > buffer.size()) {
+		throw ANGELITA128_Exception("ANGELITA128: Plaintext length is longer than the buffer.");
+	}
+	return this->encrypt(buffer.first(plaintextLength), buffer, mode, IV);
+}
+
+size_t ANGELITA128::decryptInPlace(std::span<std::uint8_t> buffer, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) const {
+	//Decrypt the whole buffer over itself, returns the plaintext length at the front of it
+	return this->decrypt(buffer, buffer, mode, IV);
+}
+
+ANGELITA128_Status ANGELITA128::encryptSmall(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, size_t& outputLength, ANGELITA128_Mode mode, const std::array<unsigned char, 16>& IV) const noexcept {
+	//Encrypt a short message with no exceptions, no allocation and no IV generation
+	//The whole blocks go straight from input to output and only the padded last block is copied
+	if (!this->keySet) {
+		return ANGELITA128_Status::KEY_NOT_SET;
+	}
+	if (missingIV(mode, IV)) {
+		return ANGELITA128_Status::ZERO_IV;
+	}
+	size_t length = encryptedSize(input.size(), mode);
+	if (output.size() < length) {
+		return ANGELITA128_Status::BUFFER_TOO_SMALL;
+	}
+	if (mode == ANGELITA128_Mode::CTR) {
+		this->encryptCTR(input.data(), output.data(), input.size(), IV);
+		outputLength = length;
+		return ANGELITA128_Status::OK;
+	}
+	if (stealsCiphertext(mode)) {
+		if (input.size() < 16) {
+			return ANGELITA128_Status::BAD_LENGTH;
+		}
+		if (output.data() != input.data()) {
+			std::memmove(output.data(), input.data(), input.size());
+		}
+		this->encryptStealing(output.data(), input.size(), mode == ANGELITA128_Mode::CBC_CTS, IV);
+		outputLength = length;
+		return ANGELITA128_Status::OK;
+	}
+
+	size_t wholeBlocks = input.size() / 16;
+	size_t tailLength = input.size() % 16;
+	std::array<unsigned char, 16> lastBlock;
+	if (tailLength > 0) {
+		std::memcpy(lastBlock.data(), input.data() + wholeBlocks * 16, tailLength);
+	}
+	std::memset(lastBlock.data() + tailLength, 16 - tailLength, 16 - tailLength);
+	if (mode == ANGELITA128_Mode::CBC) {
+		std::array<unsigned char, 16> chainBlock = IV;
+		this->encryptCBC(input.data(), output.data(), wholeBlocks, chainBlock);
+		this->encryptCBC(lastBlock.data(), output.data() + wholeBlocks * 16, 1, chainBlock);
+	}
+	else {
+		this->encryptECB(input.data(), output.data(), wholeBlocks);
+		this->encryptECB(lastBlock.data(), output.data() + wholeBlocks * 16, 1);
+	}
+	outputLength = length;
+	return ANGELITA128_Status::OK;
+}
+
+ANGELITA128_Status ANGELITA128::decryptSmall(std::span<const std::uint8_t> input, std::span<std::uint8_t> output, size_t& outputLength, ANGELITA128_Mode mode, const std::array<unsigned char, 16>& IV) const noexcept {
+	//Decrypt a short message with no exceptions and no allocation, output needs input.size() bytes
+	if (!this->keySet) {
+		return ANGELITA128_Status::KEY_NOT_SET;
+	}
+	if (output.size() < input.size()) {
+		return ANGELITA128_Status::BUFFER_TOO_SMALL;
+	}
+	if (mode == ANGELITA128_Mode::CTR) {
+		this->decryptCTR(input.data(), output.data(), input.size(), IV);
+		outputLength = input.size();
+		return ANGELITA128_Status::OK;
+	}
+	if (stealsCiphertext(mode)) {
+		if (input.size() < 16) {
+			return ANGELITA128_Status::BAD_LENGTH;
+		}
+		if (output.data() != input.data()) {
+			std::memmove(output.data(), input.data(), input.size());
+		}
+		this->decryptStealing(output.data(), input.size(), mode == ANGELITA128_Mode::CBC_CTS, IV);
+		outputLength = input.size();
+		return ANGELITA128_Status::OK;
+	}
+	if (input.size() == 0 || input.size() % 16 != 0) {
+		return ANGELITA128_Status::BAD_LENGTH;
+	}
+	if (mode == ANGELITA128_Mode::CBC) {
+		std::array<unsigned char, 16> chainBlock = IV;
+		this->decryptCBC(input.data(), output.data(), input.size() / 16, chainBlock);
+	}
+	else {
+		this->decryptECB(input.data(), output.data(), input.size() / 16);
+	}
+	unsigned int paddingSize = output[input.size() - 1];
+	if (paddingSize == 0 || paddingSize > 16) {
+		return ANGELITA128_Status::BAD_PADDING;
+	}
+	outputLength = input.size() - paddingSize;
+	return ANGELITA128_Status::OK;
+}
+
+const char* ANGELITA128::statusMessage(ANGELITA128_Status status) noexcept {
+	//Describe a status from the small message fast path
+	switch (status) {
+	case ANGELITA128_Status::OK:
+		return "OK";
+	case ANGELITA128_Status::KEY_NOT_SET:
+		return "Key must be set.";
+	case ANGELITA128_Status::BUFFER_TOO_SMALL:
+		return "Output buffer is too small.";
+	case ANGELITA128_Status::BAD_LENGTH:
+		return "Input length is not valid, must be a multiple of 16 bytes, or at least 16 bytes for ciphertext stealing.";
+	case ANGELITA128_Status::BAD_PADDING:
+		return "Invalid padding after decrypt, wrong key or mode.";
+	case ANGELITA128_Status::ZERO_IV:
+		return "IV must be set in this mode, an all-zero IV is refused.";
+	}
+	return "Unknown status.";
+}
@@ -0,0 +1,146 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 checksum methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 checksum methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_Checksum.h"
+#include <array>
+#include <cstring>
+#ifdef ANGELITA128_CRC32C_SSE42
+#include <nmmintrin.h>
+#endif
+
+//CRC32C polynomial, reflected
+static const std::uint32_t POLYNOMIAL = 0x82F63B78;
+
+static const std::array<std::array<std::uint32_t, 256>, 8>& crcTables() {
+	//Table t[0] is the usual byte at a time table, t[k] is t[0] moved on k more zero bytes, for 8 bytes a step
+	static const std::array<std::array<std::uint32_t, 256>, 8> tables = []() {
+		std::array<std::array<std::uint32_t, 256>, 8> t;
+		for (std::uint32_t n = 0; n < 256; n++) {
+			std::uint32_t crc = n;
+			for (unsigned int bit = 0; bit < 8; bit++) {
+				crc = crc & 1 ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+			}
+			t[0][n] = crc;
+		}
+		for (std::uint32_t n = 0; n < 256; n++) {
+			for (unsigned int k = 1; k < 8; k++) {
+				t[k][n] = (t[k - 1][n] >> 8) ^ t[0][t[k - 1][n] & 255];
+			}
+		}
+		return t;
+	}();
+	return tables;
+}
+
+static std::uint32_t crcTable(std::uint32_t crc, const unsigned char* data, size_t length) {
+	const std::array<std::array<std::uint32_t, 256>, 8>& t = crcTables();
+	while (length >= 8) {
+		std::uint32_t low = crc ^ ((std::uint32_t)data[0] | (std::uint32_t)data[1] << 8 | (std::uint32_t)data[2] << 16 | (std::uint32_t)data[3] << 24);
+		crc = t[7][low & 255] ^ t[6][(low >> 8) & 255] ^ t[5][(low >> 16) & 255] ^ t[4][low >> 24] ^
+			t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+		data += 8;
+		length -= 8;
+	}
+	while (length > 0) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 255];
+		length--;
+	}
+	return crc;
+}
+
+#ifdef ANGELITA128_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+static std::uint32_t crcHardware(std::uint32_t crc, const unsigned char* data, size_t length) {
+	std::uint64_t crc64 = crc;
+	while (length >= 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+		data += 8;
+		length -= 8;
+	}
+	crc = (std::uint32_t)crc64;
+	while (length > 0) {
+		crc = _mm_crc32_u8(crc, *data++);
+		length--;
+	}
+	return crc;
+}
+#endif
+
+bool ANGELITA128_Checksum::hardware() {
+#ifdef ANGELITA128_CRC32C_SSE42
+	static const bool supported = __builtin_cpu_supports("sse4.2");
+	return supported;
+#else
+	return 0;
+#endif
+}
+
+std::uint32_t ANGELITA128_Checksum::crc32c(std::uint32_t crc, const unsigned char* data, size_t length) {
+	crc = ~crc;
+#ifdef ANGELITA128_CRC32C_SSE42
+	if (hardware()) {
+		return ~crcHardware(crc, data, length);
+	}
+#endif
+	return ~crcTable(crc, data, length);
+}
+
+static std::uint32_t multiplyModP(std::uint32_t a, std::uint32_t b) {
+	//a * b modulo the polynomial, bit 31 being x^0 as in the reflected CRC
+	std::uint32_t product = 0;
+	for (std::uint32_t bit = 1u << 31; bit != 0; bit >>= 1) {
+		if (a & bit) {
+			product ^= b;
+		}
+		b = b & 1 ? (b >> 1) ^ POLYNOMIAL : b >> 1;
+	}
+	return product;
+}
+
+std::uint32_t ANGELITA128_Checksum::combine(std::uint32_t crcA, std::uint32_t crcB, std::uint64_t lengthB) {
+	//Moving crcA on by lengthB zero bytes is multiplying it by x^(8 * lengthB), built up from x^(2^k) by the bits of lengthB
+	std::uint32_t power = 1u << 31;
+	std::uint32_t square = 1u << 30;
+	for (std::uint64_t bits = lengthB * 8; bits != 0; bits >>= 1) {
+		if (bits & 1) {
+			power = multiplyModP(square, power);
+		}
+		square = multiplyModP(square, square);
+	}
+	return multiplyModP(power, crcA) ^ crcB;
+}
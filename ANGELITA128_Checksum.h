@@ -0,0 +1,60 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 checksum header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 checksum class
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+/*
+	CRC32C (Castagnoli) of plaintext, worked out on each chunk while it is in cache for the cipher.
+	On x86-64 CPUs with SSE4.2 the crc32 instruction does the work, elsewhere an 8-way table does.
+	Chunks done on different threads are put back together in order with combine().
+*/
+
+#ifndef ANGELITA128_CHECKSUM_H
+#define ANGELITA128_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ANGELITA128_CRC32C_SSE42 1
+#endif
+
+class ANGELITA128_Checksum {
+public:
+	//Carry a CRC32C on over length more bytes, starting from 0
+	static std::uint32_t crc32c(std::uint32_t crc, const unsigned char* data, size_t length);
+	//The CRC32C of A followed by B, from the CRC32Cs of each and B's length
+	static std::uint32_t combine(std::uint32_t crcA, std::uint32_t crcB, std::uint64_t lengthB);
+	static bool hardware();
+};
+
+#endif
@@ -0,0 +1,218 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 compression codec methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 compression codec methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_Codec.h"
+#include <cstring>
+#include <cstdint>
+
+static const unsigned int MIN_MATCH = 4;
+static const unsigned int HASH_BITS = 13;
+static const size_t MAX_OFFSET = 65535;
+
+static std::uint32_t read32(const unsigned char* bytes) {
+	std::uint32_t value;
+	std::memcpy(&value, bytes, 4);
+	return value;
+}
+
+static unsigned int hash4(const unsigned char* bytes) {
+	//Multiplicative hash of the next 4 bytes
+	return (read32(bytes) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static bool putLength(unsigned char*& out, const unsigned char* outEnd, size_t extra) {
+	//Write the rest of a length past 15, 255 at a time
+	while (extra >= 255) {
+		if (out >= outEnd) {
+			return 0;
+		}
+		*out++ = 255;
+		extra -= 255;
+	}
+	if (out >= outEnd) {
+		return 0;
+	}
+	*out++ = extra;
+	return 1;
+}
+
+static bool putSequence(unsigned char*& out, const unsigned char* outEnd, const unsigned char* literals, size_t literalCount, size_t offset, size_t matchLength) {
+	//Write one sequence, matchLength 0 for the last one, false if it doesn't fit
+	if (out >= outEnd) {
+		return 0;
+	}
+	unsigned char* token = out++;
+	*token = (literalCount < 15 ? literalCount : 15) << 4;
+	if (literalCount >= 15 && !putLength(out, outEnd, literalCount - 15)) {
+		return 0;
+	}
+	if ((size_t)(outEnd - out) < literalCount) {
+		return 0;
+	}
+	std::memcpy(out, literals, literalCount);
+	out += literalCount;
+	if (matchLength == 0) {
+		return 1;
+	}
+	if (outEnd - out < 2) {
+		return 0;
+	}
+	*out++ = offset & 255;
+	*out++ = offset >> 8;
+	size_t lengthCode = matchLength - MIN_MATCH;
+	*token |= lengthCode < 15 ? lengthCode : 15;
+	if (lengthCode >= 15 && !putLength(out, outEnd, lengthCode - 15)) {
+		return 0;
+	}
+	return 1;
+}
+
+size_t ANGELITA128_Codec::compress(const unsigned char* input, size_t length, unsigned char* output) {
+	//Greedy LZ: look up the last place the next 4 bytes were seen, and take the match if there is one
+	//If the sequences would not come out smaller, the chunk is stored as it is
+	std::uint32_t table[1 << HASH_BITS] = {};
+	unsigned char* out = output + 1;
+	const unsigned char* outEnd = output + length;
+	size_t position = 0;
+	size_t anchor = 0;
+	bool fits = 1;
+	while (fits && position + MIN_MATCH <= length) {
+		unsigned int h = hash4(input + position);
+		size_t candidate = table[h];
+		table[h] = position + 1;
+		if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(input + candidate - 1) != read32(input + position)) {
+			position++;
+			continue;
+		}
+		candidate--;
+		size_t matchLength = MIN_MATCH;
+		while (position + matchLength < length && input[candidate + matchLength] == input[position + matchLength]) {
+			matchLength++;
+		}
+		fits = putSequence(out, outEnd, input + anchor, position - anchor, position - candidate, matchLength);
+		position += matchLength;
+		anchor = position;
+	}
+	if (fits) {
+		fits = putSequence(out, outEnd, input + anchor, length - anchor, 0, 0);
+	}
+	if (fits) {
+		output[0] = 1;
+		return out - output;
+	}
+	output[0] = 0;
+	if (length > 0) {
+		std::memcpy(output + 1, input, length);
+	}
+	return length + 1;
+}
+
+static size_t getLength(const unsigned char*& in, const unsigned char* inEnd) {
+	//Read the rest of a length past 15
+	size_t total = 0;
+	for (;;) {
+		if (in >= inEnd) {
+			throw ANGELITA128_Exception("ANGELITA128: Compressed chunk is damaged.");
+		}
+		unsigned char byte = *in++;
+		total += byte;
+		if (byte != 255) {
+			return total;
+		}
+	}
+}
+
+void ANGELITA128_Codec::decompress(const unsigned char* input, size_t length, unsigned char* output, size_t outputLength) {
+	//Undo compress(), every length and offset is checked against the buffers
+	if (length == 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Compressed chunk is damaged.");
+	}
+	if (input[0] == 0) {
+		if (length - 1 != outputLength) {
+			throw ANGELITA128_Exception("ANGELITA128: Compressed chunk is damaged.");
+		}
+		if (outputLength > 0) {
+			std::memcpy(output, input + 1, outputLength);
+		}
+		return;
+	}
+	if (input[0] != 1) {
+		throw ANGELITA128_Exception("ANGELITA128: Compressed chunk has an unknown format.");
+	}
+
+	const unsigned char* in = input + 1;
+	const unsigned char* inEnd = input + length;
+	size_t position = 0;
+	for (;;) {
+		if (in >= inEnd) {
+			throw ANGELITA128_Exception("ANGELITA128: Compressed chunk is damaged.");
+		}
+		unsigned char token = *in++;
+		size_t literalCount = token >> 4;
+		if (literalCount == 15) {
+			literalCount += getLength(in, inEnd);
+		}
+		if ((size_t)(inEnd - in) < literalCount || outputLength - position < literalCount) {
+			throw ANGELITA128_Exception("ANGELITA128: Compressed chunk is damaged.");
+		}
+		std::memcpy(output + position, in, literalCount);
+		in += literalCount;
+		position += literalCount;
+		if (in == inEnd) {
+			break;
+		}
+
+		if (inEnd - in < 2) {
+			throw ANGELITA128_Exception("ANGELITA128: Compressed chunk is damaged.");
+		}
+		size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+		size_t matchLength = (token & 15) + MIN_MATCH;
+		if ((token & 15) == 15) {
+			matchLength += getLength(in, inEnd);
+		}
+		if (offset == 0 || offset > position || outputLength - position < matchLength) {
+			throw ANGELITA128_Exception("ANGELITA128: Compressed chunk is damaged.");
+		}
+		//Byte by byte, the match may overlap what it is copying
+		for (size_t i = 0; i < matchLength; i++, position++) {
+			output[position] = output[position - offset];
+		}
+	}
+	if (position != outputLength) {
+		throw ANGELITA128_Exception("ANGELITA128: Compressed chunk is damaged.");
+	}
+}
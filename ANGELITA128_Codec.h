@@ -0,0 +1,59 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 compression codec header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 compression codec class
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+/*
+	Chunk compression, applied to container chunks before they are encrypted.
+
+	A compressed chunk starts with one byte: 0 the rest is the chunk as it was (it didn't get smaller),
+	1 the rest is LZ sequences, each:
+		token: high 4 bits literal count, low 4 bits match length - 4, 15 means more length bytes follow
+		more literal count bytes (added up, each 255 means another follows), the literals
+		match offset back from the current position (2, little endian), more match length bytes
+	The last sequence has only literals, and ends the chunk.
+*/
+
+#ifndef ANGELITA128_CODEC_H
+#define ANGELITA128_CODEC_H
+
+#include "ANGELITA128_Exception.h"
+#include <cstddef>
+
+class ANGELITA128_Codec {
+public:
+	//Compress length bytes of input into output, which needs length + 1 bytes, returns the compressed length
+	static size_t compress(const unsigned char* input, size_t length, unsigned char* output);
+	//Decompress into exactly outputLength bytes, throws if the compressed data is damaged
+	static void decompress(const unsigned char* input, size_t length, unsigned char* output, size_t outputLength);
+};
+
+#endif
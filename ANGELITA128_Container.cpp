@@ -0,0 +1,717 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 chunked container methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 chunked container methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include "ANGELITA128_IO.h"
+#include "ANGELITA128_Codec.h"
+#include "ANGELITA128_Checksum.h"
+#include <cstring>
+#include <regex>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+static const char CONTAINER_MAGIC[8] = { 'A', 'N', 'G', 'E', 'L', 'C', 'H', 'K' };
+
+static void putU32(unsigned char* bytes, std::uint32_t value) {
+	for (unsigned int i = 0; i < 4; i++) {
+		bytes[i] = (value >> (8 * i)) & 255;
+	}
+}
+
+static void putU64(unsigned char* bytes, std::uint64_t value) {
+	for (unsigned int i = 0; i < 8; i++) {
+		bytes[i] = (value >> (8 * i)) & 255;
+	}
+}
+
+static std::uint32_t getU32(const unsigned char* bytes) {
+	std::uint32_t value = 0;
+	for (unsigned int i = 0; i < 4; i++) {
+		value |= (std::uint32_t)bytes[i] << (8 * i);
+	}
+	return value;
+}
+
+static std::uint64_t getU64(const unsigned char* bytes) {
+	std::uint64_t value = 0;
+	for (unsigned int i = 0; i < 8; i++) {
+		value |= (std::uint64_t)bytes[i] << (8 * i);
+	}
+	return value;
+}
+
+unsigned char ANGELITA128_Container::modeNumber(std::string mode) {
+	if (mode == "cbc") {
+		return MODE_CBC;
+	}
+	if (mode == "ctr") {
+		return MODE_CTR;
+	}
+	throw ANGELITA128_Exception("ANGELITA128: Invalid container mode, must be \"cbc\" or \"ctr\".");
+}
+
+std::string ANGELITA128_Container::modeName(unsigned char mode) {
+	if (mode == MODE_CBC) {
+		return "cbc";
+	}
+	if (mode == MODE_CTR) {
+		return "ctr";
+	}
+	throw ANGELITA128_Exception("ANGELITA128: Container has an unknown mode.");
+}
+
+unsigned char ANGELITA128_Container::codecNumber(std::string codec) {
+	if (codec == "none") {
+		return CODEC_NONE;
+	}
+	if (codec == "lz") {
+		return CODEC_LZ;
+	}
+	throw ANGELITA128_Exception("ANGELITA128: Invalid container codec, must be \"none\" or \"lz\".");
+}
+
+std::string ANGELITA128_Container::codecName(unsigned char codec) {
+	if (codec == CODEC_NONE) {
+		return "none";
+	}
+	if (codec == CODEC_LZ) {
+		return "lz";
+	}
+	throw ANGELITA128_Exception("ANGELITA128: Container has an unknown codec.");
+}
+
+ANGELITA128_ContainerHeader ANGELITA128_Container::readHeader(int fd) {
+	//Read and check the container header
+	unsigned char bytes[HEADER_SIZE];
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size < HEADER_SIZE) {
+		throw ANGELITA128_Exception("ANGELITA128: File is not an ANGELITA128 container.");
+	}
+	ANGELITA128_IO::readAt(fd, bytes, HEADER_SIZE, 0);
+	if (std::memcmp(bytes, CONTAINER_MAGIC, 8) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: File is not an ANGELITA128 container.");
+	}
+	ANGELITA128_ContainerHeader header;
+	header.version = bytes[8];
+	header.mode = bytes[9];
+	header.codec = bytes[10];
+	header.flags = bytes[11];
+	header.chunkSize = getU32(bytes + 12);
+	header.totalLength = getU64(bytes + 16);
+	header.chunkCount = getU64(bytes + 24);
+	header.indexOffset = getU64(bytes + 32);
+	header.checksum = getU32(bytes + 40);
+	if (header.version != 1) {
+		throw ANGELITA128_Exception("ANGELITA128: Container version is not supported.");
+	}
+	if (header.flags & ~FLAG_CHECKSUM) {
+		throw ANGELITA128_Exception("ANGELITA128: Container flags are not supported.");
+	}
+	modeName(header.mode);
+	codecName(header.codec);
+	if (header.chunkSize == 0 || header.chunkSize % 16 != 0 ||
+		header.indexOffset + header.chunkCount * entrySize(header) > (std::uint64_t)fileStat.st_size) {
+		throw ANGELITA128_Exception("ANGELITA128: Container header is damaged.");
+	}
+	return header;
+}
+
+void ANGELITA128_Container::writeHeader(int fd, const ANGELITA128_ContainerHeader& header) {
+	unsigned char bytes[HEADER_SIZE] = {};
+	std::memcpy(bytes, CONTAINER_MAGIC, 8);
+	bytes[8] = header.version;
+	bytes[9] = header.mode;
+	bytes[10] = header.codec;
+	bytes[11] = header.flags;
+	putU32(bytes + 12, header.chunkSize);
+	putU64(bytes + 16, header.totalLength);
+	putU64(bytes + 24, header.chunkCount);
+	putU64(bytes + 32, header.indexOffset);
+	putU32(bytes + 40, header.checksum);
+	ANGELITA128_IO::writeAt(fd, bytes, HEADER_SIZE, 0);
+}
+
+unsigned int ANGELITA128_Container::entrySize(const ANGELITA128_ContainerHeader& header) {
+	//A checksummed container keeps each chunk's CRC32C after its index entry
+	return (header.flags & FLAG_CHECKSUM) ? CHECKSUM_ENTRY_SIZE : ENTRY_SIZE;
+}
+
+std::uint32_t ANGELITA128_Container::plaintextChecksum(const std::vector<ANGELITA128_ChunkEntry>& entries) {
+	//Combine the chunk CRC32Cs in order into the CRC32C of the whole plaintext
+	std::uint32_t checksum = 0;
+	for (const ANGELITA128_ChunkEntry& entry : entries) {
+		checksum = ANGELITA128_Checksum::combine(checksum, entry.checksum, entry.plainLength);
+	}
+	return checksum;
+}
+
+std::uint64_t ANGELITA128_Container::compact(int fd, const ANGELITA128_ContainerHeader& header, std::vector<ANGELITA128_ChunkEntry>& entries) {
+	//Move the chunks down in file order so they follow the header with no gaps, and return where the last one ends
+	//Each chunk is read whole before it is written, and it only ever moves down, so nothing is overwritten before it is read
+	std::vector<size_t> order(entries.size());
+	for (size_t c = 0; c < entries.size(); c++) {
+		order[c] = c;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return entries[a].offset < entries[b].offset; });
+	std::vector<unsigned char> stored(header.chunkSize + CHUNK_SPARE);
+	std::uint64_t dataEnd = HEADER_SIZE;
+	for (size_t c : order) {
+		ANGELITA128_ChunkEntry& entry = entries[c];
+		if (entry.offset != dataEnd) {
+			ANGELITA128_IO::readAt(fd, stored.data(), entry.storedLength, entry.offset);
+			ANGELITA128_IO::writeAt(fd, stored.data(), entry.storedLength, dataEnd);
+			entry.offset = dataEnd;
+		}
+		dataEnd += entry.storedLength;
+	}
+	return dataEnd;
+}
+
+std::vector<ANGELITA128_ChunkEntry> ANGELITA128_Container::readIndex(int fd, const ANGELITA128_ContainerHeader& header) {
+	//Read the chunk index that follows the last chunk
+	unsigned int size = entrySize(header);
+	std::vector<unsigned char> bytes(header.chunkCount * size);
+	ANGELITA128_IO::readAt(fd, bytes.data(), bytes.size(), header.indexOffset);
+	std::vector<ANGELITA128_ChunkEntry> entries(header.chunkCount);
+	for (std::uint64_t c = 0; c < header.chunkCount; c++) {
+		const unsigned char* entryBytes = bytes.data() + c * size;
+		entries[c].offset = getU64(entryBytes);
+		entries[c].storedLength = getU32(entryBytes + 8);
+		entries[c].plainLength = getU32(entryBytes + 12);
+		std::memcpy(entries[c].IV.data(), entryBytes + 16, 16);
+		if (size == CHECKSUM_ENTRY_SIZE) {
+			entries[c].checksum = getU32(entryBytes + 32);
+		}
+		//Stored chunks are read into buffers of chunk size plus CHUNK_SPARE, so no entry may claim more than that
+		//and an uncompressed ctr chunk is exactly as long as its plaintext
+		if (entries[c].offset + entries[c].storedLength > header.indexOffset || entries[c].plainLength > header.chunkSize ||
+			entries[c].storedLength > (std::uint64_t)header.chunkSize + CHUNK_SPARE ||
+			(header.mode == MODE_CTR && header.codec == CODEC_NONE && entries[c].storedLength != entries[c].plainLength) ||
+			(c + 1 < header.chunkCount && entries[c].plainLength != header.chunkSize)) {
+			throw ANGELITA128_Exception("ANGELITA128: Container index is damaged.");
+		}
+	}
+	return entries;
+}
+
+void ANGELITA128_Container::writeIndex(int fd, const ANGELITA128_ContainerHeader& header, const std::vector<ANGELITA128_ChunkEntry>& entries) {
+	unsigned int size = entrySize(header);
+	std::vector<unsigned char> bytes(entries.size() * size);
+	for (size_t c = 0; c < entries.size(); c++) {
+		unsigned char* entryBytes = bytes.data() + c * size;
+		putU64(entryBytes, entries[c].offset);
+		putU32(entryBytes + 8, entries[c].storedLength);
+		putU32(entryBytes + 12, entries[c].plainLength);
+		std::memcpy(entryBytes + 16, entries[c].IV.data(), 16);
+		if (size == CHECKSUM_ENTRY_SIZE) {
+			putU32(entryBytes + 32, entries[c].checksum);
+		}
+	}
+	ANGELITA128_IO::writeAt(fd, bytes.data(), bytes.size(), header.indexOffset);
+}
+
+
+///////////////////
+//Chunk routines
+///////////////////
+
+std::array<unsigned char, 16> ANGELITA128::chunkIV(std::array<unsigned char, 16> firstIV, std::uint64_t chunk) const {
+	//Each chunk's IV or starting counter is the file's GLORIA IV plus the chunk number, encrypted
+	counterAdd(firstIV, chunk);
+	this->encryptLanes(firstIV.data(), 1);
+	return firstIV;
+}
+
+size_t ANGELITA128::encryptChunk(std::string mode, const unsigned char* plaintext, unsigned char* stored, ANGELITA128_ChunkEntry& entry, unsigned char codec) const {
+	//Encrypt one chunk of entry.plainLength bytes with entry.IV into stored, which needs CHUNK_SPARE spare bytes
+	//With a codec the chunk is compressed into stored first and encrypted there
+	//cbc chunks are padded to whole blocks, ctr chunks keep their length
+	size_t payloadLength = entry.plainLength;
+	if (codec != ANGELITA128_Container::CODEC_NONE) {
+		payloadLength = ANGELITA128_Codec::compress(plaintext, entry.plainLength, stored);
+		plaintext = stored;
+	}
+	if (mode == "ctr") {
+		this->encryptCTR(plaintext, stored, payloadLength, entry.IV);
+		entry.storedLength = payloadLength;
+		return entry.storedLength;
+	}
+	unsigned int paddingSize = 16 - (payloadLength % 16);
+	if (plaintext != stored) {
+		std::memcpy(stored, plaintext, payloadLength);
+	}
+	std::memset(stored + payloadLength, paddingSize, paddingSize);
+	std::array<unsigned char, 16> chainBlock = entry.IV;
+	entry.storedLength = payloadLength + paddingSize;
+	this->encryptCBC(stored, stored, entry.storedLength / 16, chainBlock);
+	return entry.storedLength;
+}
+
+void ANGELITA128::decryptChunk(std::string mode, const unsigned char* stored, unsigned char* plaintext, const ANGELITA128_ChunkEntry& entry, unsigned char codec) const {
+	//Decrypt one whole chunk into entry.plainLength bytes of plaintext
+	//Without a codec plaintext needs storedLength bytes of room, with one the chunk is decrypted aside and decompressed into it
+	if (codec != ANGELITA128_Container::CODEC_NONE) {
+		size_t payloadLength = entry.storedLength;
+		bool damaged = mode == "ctr" ? payloadLength == 0 || payloadLength > (size_t)entry.plainLength + 1
+			: payloadLength % 16 != 0 || payloadLength == 0 || payloadLength > (size_t)entry.plainLength + 17;
+		if (damaged) {
+			throw ANGELITA128_Exception("ANGELITA128: Container chunk length is damaged.");
+		}
+		std::vector<unsigned char> payload(payloadLength);
+		std::array<unsigned char, 16> chainBlock = entry.IV;
+		if (mode == "ctr") {
+			this->decryptCTR(stored, payload.data(), payloadLength, entry.IV);
+		}
+		else {
+			this->decryptCBC(stored, payload.data(), payloadLength / 16, chainBlock);
+			unsigned int paddingSize = payload[payloadLength - 1];
+			if (paddingSize == 0 || paddingSize > 16) {
+				throw ANGELITA128_Exception("ANGELITA128: Invalid padding after decrypt, wrong key or damaged container.");
+			}
+			payloadLength -= paddingSize;
+		}
+		ANGELITA128_Codec::decompress(payload.data(), payloadLength, plaintext, entry.plainLength);
+		return;
+	}
+	if (mode == "ctr") {
+		if (entry.storedLength != entry.plainLength) {
+			throw ANGELITA128_Exception("ANGELITA128: Container chunk length is damaged.");
+		}
+		this->decryptCTR(stored, plaintext, entry.plainLength, entry.IV);
+		return;
+	}
+	if (entry.storedLength % 16 != 0 || entry.storedLength < entry.plainLength + 1 || entry.storedLength > entry.plainLength + 16) {
+		throw ANGELITA128_Exception("ANGELITA128: Container chunk length is damaged.");
+	}
+	std::array<unsigned char, 16> chainBlock = entry.IV;
+	this->decryptCBC(stored, plaintext, entry.storedLength / 16, chainBlock);
+	unsigned int paddingSize = plaintext[entry.storedLength - 1];
+	if (paddingSize != entry.storedLength - entry.plainLength) {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid padding after decrypt, wrong key or damaged container.");
+	}
+}
+
+void ANGELITA128::decryptChunkRange(int fd, std::string mode, const ANGELITA128_ChunkEntry& entry, size_t start, size_t length, unsigned char* output, unsigned char codec) const {
+	//Decrypt plaintext bytes [start, start + length) of one chunk, reading only the blocks they are in
+	//ctr blocks stand alone, a cbc block also needs the ciphertext block before it (or the IV)
+	//A compressed chunk can only be decompressed from the start, so it is read and decrypted whole
+	if (codec != ANGELITA128_Container::CODEC_NONE) {
+		std::vector<unsigned char> stored(entry.storedLength);
+		std::vector<unsigned char> plaintext(entry.plainLength);
+		ANGELITA128_IO::readAt(fd, stored.data(), entry.storedLength, entry.offset);
+		this->decryptChunk(mode, stored.data(), plaintext.data(), entry, codec);
+		std::memcpy(output, plaintext.data() + start, length);
+		return;
+	}
+	size_t firstBlock = start / 16;
+	size_t lastBlock = (start + length + 15) / 16;
+	size_t blockCount = lastBlock - firstBlock;
+	std::vector<unsigned char> blocks((blockCount + 1) * 16);
+	if (mode == "ctr") {
+		size_t readLength = std::min<size_t>(blockCount * 16, entry.storedLength - firstBlock * 16);
+		ANGELITA128_IO::readAt(fd, blocks.data(), readLength, entry.offset + firstBlock * 16);
+		std::array<unsigned char, 16> counterBlock = entry.IV;
+		counterAdd(counterBlock, firstBlock);
+		this->decryptCTR(blocks.data(), blocks.data(), readLength, counterBlock);
+		std::memcpy(output, blocks.data() + start % 16, length);
+		return;
+	}
+	std::array<unsigned char, 16> chainBlock = entry.IV;
+	if (firstBlock > 0) {
+		ANGELITA128_IO::readAt(fd, chainBlock.data(), 16, entry.offset + (firstBlock - 1) * 16);
+	}
+	ANGELITA128_IO::readAt(fd, blocks.data(), blockCount * 16, entry.offset + firstBlock * 16);
+	this->decryptCBC(blocks.data(), blocks.data(), blockCount, chainBlock);
+	std::memcpy(output, blocks.data() + start % 16, length);
+}
+
+
+///////////////////
+//Container interface
+///////////////////
+
+void ANGELITA128::encryptChunked(std::string file, std::string mode, size_t chunkSize, unsigned int threadCount, std::string codec, bool checksum) {
+	//Encrypt the file into the chunked container format, as file + ".ANGELITA128C"
+	//Chunks are compressed (with a codec) and encrypted in parallel a batch at a time, then written in order followed by the index
+	//With checksum each chunk's CRC32C is taken just before it is encrypted and kept in the index,
+	//and they are combined in order into the header
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to encrypt.");
+	}
+	ANGELITA128_ContainerHeader header;
+	header.mode = ANGELITA128_Container::modeNumber(mode);
+	header.codec = ANGELITA128_Container::codecNumber(codec);
+	header.flags = checksum ? ANGELITA128_Container::FLAG_CHECKSUM : 0;
+	if (chunkSize < 16 || chunkSize % 16 != 0 || chunkSize > 1073741824) {
+		throw ANGELITA128_Exception("ANGELITA128: Chunk size must be a multiple of 16 bytes, up to 1 GiB.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+
+	int inputFd = open(file.c_str(), O_RDONLY);
+	if (inputFd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and encrypt.");
+	}
+	struct stat inputStat;
+	fstat(inputFd, &inputStat);
+	std::string newFileName = file + ".ANGELITA128C";
+	int outputFd = open(newFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+	if (outputFd < 0) {
+		close(inputFd);
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after encrypt.");
+	}
+
+	//GLORIA borrows the S-Box and P-Box, so it runs before the chunk threads
+	std::array<unsigned char, 16> firstIV = this->GLORIA();
+	header.chunkSize = chunkSize;
+	header.totalLength = inputStat.st_size;
+	header.chunkCount = (header.totalLength + chunkSize - 1) / chunkSize;
+	std::vector<ANGELITA128_ChunkEntry> entries(header.chunkCount);
+
+	try {
+		size_t batchChunks = threadCount * 4;
+		std::vector<std::vector<unsigned char>> plaintexts(batchChunks, std::vector<unsigned char>(chunkSize));
+		std::vector<std::vector<unsigned char>> stored(batchChunks, std::vector<unsigned char>(chunkSize + ANGELITA128_Container::CHUNK_SPARE));
+		std::uint64_t outputOffset = ANGELITA128_Container::HEADER_SIZE;
+		for (std::uint64_t batchStart = 0; batchStart < header.chunkCount; batchStart += batchChunks) {
+			size_t count = std::min<std::uint64_t>(batchChunks, header.chunkCount - batchStart);
+			for (size_t k = 0; k < count; k++) {
+				ANGELITA128_ChunkEntry& entry = entries[batchStart + k];
+				entry.plainLength = std::min<std::uint64_t>(chunkSize, header.totalLength - (batchStart + k) * chunkSize);
+				ANGELITA128_IO::readAt(inputFd, plaintexts[k].data(), entry.plainLength, (batchStart + k) * chunkSize);
+			}
+			this->parallelFor(count, threadCount, [&](size_t k) {
+				ANGELITA128_ChunkEntry& entry = entries[batchStart + k];
+				entry.IV = this->chunkIV(firstIV, batchStart + k);
+				if (checksum) {
+					entry.checksum = ANGELITA128_Checksum::crc32c(0, plaintexts[k].data(), entry.plainLength);
+				}
+				this->encryptChunk(mode, plaintexts[k].data(), stored[k].data(), entry, header.codec);
+			});
+			for (size_t k = 0; k < count; k++) {
+				ANGELITA128_ChunkEntry& entry = entries[batchStart + k];
+				if (checksum) {
+					header.checksum = ANGELITA128_Checksum::combine(header.checksum, entry.checksum, entry.plainLength);
+				}
+				entry.offset = outputOffset;
+				ANGELITA128_IO::writeAt(outputFd, stored[k].data(), entry.storedLength, outputOffset);
+				outputOffset += entry.storedLength;
+			}
+		}
+		header.indexOffset = outputOffset;
+		ANGELITA128_Container::writeIndex(outputFd, header, entries);
+		ANGELITA128_Container::writeHeader(outputFd, header);
+	}
+	catch (...) {
+		close(inputFd);
+		close(outputFd);
+		unlink(newFileName.c_str());
+		throw;
+	}
+	close(inputFd);
+	if (close(outputFd) != 0) {
+		unlink(newFileName.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not write file after encrypt.");
+	}
+	if (unlink(file.c_str()) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not remove the original file after encrypt.");
+	}
+}
+
+void ANGELITA128::decryptChunked(std::string file, unsigned int threadCount) {
+	//Decrypt a chunked container back to the file name without ".ANGELITA128C"
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+
+	int inputFd = open(file.c_str(), O_RDONLY);
+	if (inputFd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and decrypt.");
+	}
+	ANGELITA128_ContainerHeader header;
+	std::vector<ANGELITA128_ChunkEntry> entries;
+	try {
+		header = ANGELITA128_Container::readHeader(inputFd);
+		entries = ANGELITA128_Container::readIndex(inputFd, header);
+	}
+	catch (...) {
+		close(inputFd);
+		throw;
+	}
+	std::string mode = ANGELITA128_Container::modeName(header.mode);
+	struct stat inputStat;
+	fstat(inputFd, &inputStat);
+
+	std::string newFileName = std::regex_replace(file, std::regex("(\\.ANGELITA128C)$"), "");
+	std::string outputName = newFileName;
+	if (newFileName == file) {
+		outputName = file + ".ANGELITA128_decrypt";
+	}
+	int outputFd = open(outputName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+	if (outputFd < 0) {
+		close(inputFd);
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after decrypt.");
+	}
+
+	try {
+		size_t batchChunks = threadCount * 4;
+		std::vector<std::vector<unsigned char>> stored(batchChunks, std::vector<unsigned char>(header.chunkSize + ANGELITA128_Container::CHUNK_SPARE));
+		std::vector<std::vector<unsigned char>> plaintexts(batchChunks, std::vector<unsigned char>(header.chunkSize + 16));
+		bool checksum = header.flags & ANGELITA128_Container::FLAG_CHECKSUM;
+		std::vector<std::uint32_t> chunkChecksums(batchChunks);
+		std::uint32_t plaintextChecksum = 0;
+		for (std::uint64_t batchStart = 0; batchStart < header.chunkCount; batchStart += batchChunks) {
+			size_t count = std::min<std::uint64_t>(batchChunks, header.chunkCount - batchStart);
+			for (size_t k = 0; k < count; k++) {
+				const ANGELITA128_ChunkEntry& entry = entries[batchStart + k];
+				ANGELITA128_IO::readAt(inputFd, stored[k].data(), entry.storedLength, entry.offset);
+			}
+			this->parallelFor(count, threadCount, [&](size_t k) {
+				this->decryptChunk(mode, stored[k].data(), plaintexts[k].data(), entries[batchStart + k], header.codec);
+				if (checksum) {
+					chunkChecksums[k] = ANGELITA128_Checksum::crc32c(0, plaintexts[k].data(), entries[batchStart + k].plainLength);
+				}
+			});
+			for (size_t k = 0; k < count; k++) {
+				if (checksum) {
+					plaintextChecksum = ANGELITA128_Checksum::combine(plaintextChecksum, chunkChecksums[k], entries[batchStart + k].plainLength);
+				}
+				ANGELITA128_IO::writeAt(outputFd, plaintexts[k].data(), entries[batchStart + k].plainLength, (batchStart + k) * header.chunkSize);
+			}
+		}
+		if (checksum && plaintextChecksum != header.checksum) {
+			throw ANGELITA128_Exception("ANGELITA128: Plaintext checksum does not match, wrong key or damaged container.");
+		}
+	}
+	catch (...) {
+		close(inputFd);
+		close(outputFd);
+		unlink(outputName.c_str());
+		throw;
+	}
+	close(inputFd);
+	if (close(outputFd) != 0) {
+		unlink(outputName.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not write file after decrypt.");
+	}
+	if (outputName != newFileName) {
+		if (std::rename(outputName.c_str(), newFileName.c_str()) != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not rename file after decrypt.");
+		}
+	}
+	else if (unlink(file.c_str()) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not remove the encrypted file after decrypt.");
+	}
+}
+
+std::vector<unsigned char> ANGELITA128::readChunked(std::string file, std::uint64_t offset, size_t length, unsigned int threadCount) const {
+	//Read plaintext bytes [offset, offset + length) of a chunked container, clipped to the end of the plaintext
+	//Only the blocks of the chunks in the range are read and decrypted, the chunks in parallel
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and decrypt.");
+	}
+	std::vector<unsigned char> output;
+	try {
+		ANGELITA128_ContainerHeader header = ANGELITA128_Container::readHeader(fd);
+		std::vector<ANGELITA128_ChunkEntry> entries = ANGELITA128_Container::readIndex(fd, header);
+		std::string mode = ANGELITA128_Container::modeName(header.mode);
+		if (offset >= header.totalLength) {
+			close(fd);
+			return output;
+		}
+		length = std::min<std::uint64_t>(length, header.totalLength - offset);
+		if (length == 0) {
+			close(fd);
+			return output;
+		}
+		output.resize(length);
+		std::uint64_t firstChunk = offset / header.chunkSize;
+		std::uint64_t lastChunk = (offset + length - 1) / header.chunkSize;
+		this->parallelFor(lastChunk - firstChunk + 1, threadCount, [&](size_t k) {
+			std::uint64_t c = firstChunk + k;
+			std::uint64_t chunkStart = c * header.chunkSize;
+			std::uint64_t start = std::max<std::uint64_t>(offset, chunkStart);
+			std::uint64_t end = std::min<std::uint64_t>(offset + length, chunkStart + entries[c].plainLength);
+			this->decryptChunkRange(fd, mode, entries[c], start - chunkStart, end - start, output.data() + (start - offset), header.codec);
+		});
+	}
+	catch (...) {
+		close(fd);
+		throw;
+	}
+	close(fd);
+	return output;
+}
+
+void ANGELITA128::updateChunked(std::string file, std::uint64_t offset, const std::vector<unsigned char>& patch, unsigned int threadCount) {
+	//Write patch over the plaintext of a chunked container at offset, growing it if the patch runs past the end
+	//(a gap past the old end reads as zeros). Only the chunks the patch touches are decrypted and encrypted again,
+	//each with a fresh IV, so the work follows the size of the patch and not the size of the file.
+	//A chunk that still fits its slot (up to the next chunk) is rewritten in place, one that grew past it is moved
+	//past the last chunk, then the index and header are rewritten. Once the space no chunk uses passes a quarter of
+	//the chunk data the chunks are moved down over it. The update is not atomic if the system fails part way.
+	//A checksummed container keeps its checksum: the patched chunks get new CRC32Cs in the index
+	//and the whole plaintext CRC32C is combined again from all of them.
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to update.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+	if (patch.empty()) {
+		return;
+	}
+
+	int fd = open(file.c_str(), O_RDWR);
+	if (fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for update.");
+	}
+	try {
+		ANGELITA128_ContainerHeader header = ANGELITA128_Container::readHeader(fd);
+		std::vector<ANGELITA128_ChunkEntry> entries = ANGELITA128_Container::readIndex(fd, header);
+		std::string mode = ANGELITA128_Container::modeName(header.mode);
+		std::uint64_t chunkSize = header.chunkSize;
+		std::uint64_t patchEnd = offset + patch.size();
+		std::uint64_t newLength = std::max(header.totalLength, patchEnd);
+		std::uint64_t oldCount = header.chunkCount;
+
+		//Chunks from the patch start, or the old end if the patch starts past it, through the patch end
+		std::uint64_t firstChunk = std::min(offset, header.totalLength) / chunkSize;
+		std::uint64_t lastChunk = (patchEnd - 1) / chunkSize;
+		size_t count = lastChunk - firstChunk + 1;
+		std::vector<ANGELITA128_ChunkEntry> oldEntries = entries;
+		entries.resize((newLength + chunkSize - 1) / chunkSize);
+
+		//Fresh IVs come from GLORIA, which borrows the S-Box and P-Box, so they are made before the threads
+		for (size_t k = 0; k < count; k++) {
+			entries[firstChunk + k].IV = this->GLORIA();
+		}
+
+		bool checksum = header.flags & ANGELITA128_Container::FLAG_CHECKSUM;
+		std::vector<std::vector<unsigned char>> stored(count, std::vector<unsigned char>(chunkSize + ANGELITA128_Container::CHUNK_SPARE));
+		this->parallelFor(count, threadCount, [&](size_t k) {
+			std::uint64_t c = firstChunk + k;
+			std::uint64_t chunkStart = c * chunkSize;
+			ANGELITA128_ChunkEntry& entry = entries[c];
+			entry.plainLength = std::min(chunkSize, newLength - chunkStart);
+			std::vector<unsigned char> plaintext(chunkSize + 16, 0);
+
+			//The old plaintext is only needed where the patch doesn't cover the chunk
+			//Chunks between the old end and a patch past it are not covered at all
+			std::uint64_t coverStart = std::max(offset, chunkStart);
+			std::uint64_t coverEnd = std::min(patchEnd, chunkStart + entry.plainLength);
+			bool covered = coverStart == chunkStart && coverEnd == chunkStart + entry.plainLength;
+			if (c < oldCount && !covered) {
+				const ANGELITA128_ChunkEntry& oldEntry = oldEntries[c];
+				ANGELITA128_IO::readAt(fd, stored[k].data(), oldEntry.storedLength, oldEntry.offset);
+				this->decryptChunk(mode, stored[k].data(), plaintext.data(), oldEntry, header.codec);
+				//The old chunk is checked before any of it is kept, so a wrong key can't be written back under a fresh CRC
+				if (checksum && ANGELITA128_Checksum::crc32c(0, plaintext.data(), oldEntry.plainLength) != oldEntry.checksum) {
+					throw ANGELITA128_Exception("ANGELITA128: Chunk checksum does not match, wrong key or damaged container.");
+				}
+				std::memset(plaintext.data() + oldEntry.plainLength, 0, chunkSize + 16 - oldEntry.plainLength);
+			}
+			if (coverEnd > coverStart) {
+				std::memcpy(plaintext.data() + (coverStart - chunkStart), patch.data() + (coverStart - offset), coverEnd - coverStart);
+			}
+			if (checksum) {
+				entry.checksum = ANGELITA128_Checksum::crc32c(0, plaintext.data(), entry.plainLength);
+			}
+			this->encryptChunk(mode, plaintext.data(), stored[k].data(), entry, header.codec);
+		});
+
+		//A chunk's slot runs to the next chunk in the file or the index, so it takes in space a chunk before it left behind
+		std::vector<std::uint64_t> oldOffsets(oldCount);
+		for (std::uint64_t c = 0; c < oldCount; c++) {
+			oldOffsets[c] = oldEntries[c].offset;
+		}
+		std::sort(oldOffsets.begin(), oldOffsets.end());
+
+		//Chunks that fit go back where they were, the rest after the last chunk, where the index was
+		std::uint64_t dataEnd = header.indexOffset;
+		for (size_t k = 0; k < count; k++) {
+			std::uint64_t c = firstChunk + k;
+			std::uint64_t slotEnd = header.indexOffset;
+			if (c < oldCount) {
+				auto next = std::upper_bound(oldOffsets.begin(), oldOffsets.end(), oldEntries[c].offset);
+				if (next != oldOffsets.end()) {
+					slotEnd = *next;
+				}
+			}
+			if (c < oldCount && oldEntries[c].offset + entries[c].storedLength <= slotEnd) {
+				entries[c].offset = oldEntries[c].offset;
+			}
+			else {
+				entries[c].offset = dataEnd;
+				dataEnd += entries[c].storedLength;
+			}
+			ANGELITA128_IO::writeAt(fd, stored[k].data(), entries[c].storedLength, entries[c].offset);
+		}
+
+		//Space left behind by chunks that shrank or moved is given back once it passes a quarter of the chunk data
+		std::uint64_t liveLength = 0;
+		for (const ANGELITA128_ChunkEntry& entry : entries) {
+			liveLength += entry.storedLength;
+		}
+		if ((dataEnd - ANGELITA128_Container::HEADER_SIZE - liveLength) * 4 > dataEnd - ANGELITA128_Container::HEADER_SIZE) {
+			dataEnd = ANGELITA128_Container::compact(fd, header, entries);
+		}
+
+		header.totalLength = newLength;
+		header.chunkCount = entries.size();
+		if (checksum) {
+			header.checksum = ANGELITA128_Container::plaintextChecksum(entries);
+		}
+		header.indexOffset = dataEnd;
+		ANGELITA128_Container::writeIndex(fd, header, entries);
+		if (ftruncate(fd, header.indexOffset + header.chunkCount * ANGELITA128_Container::entrySize(header)) != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not write file after update.");
+		}
+		ANGELITA128_Container::writeHeader(fd, header);
+	}
+	catch (...) {
+		close(fd);
+		throw;
+	}
+	if (close(fd) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not write file after update.");
+	}
+}
@@ -0,0 +1,109 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 chunked container header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 chunked container format
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+/*
+	Chunked container layout, all numbers little endian:
+
+	Header (64 bytes):
+		magic "ANGELCHK", version, mode (1 cbc, 2 ctr), codec (0 none, 1 lz), flags (1 checksum),
+		chunk size (4), total plaintext length (8), chunk count (8), index offset (8),
+		CRC32C of the whole plaintext if the checksum flag is set (4), reserved
+	Chunks:
+		each chunk of plaintext encrypted on its own with its own IV (cbc) or starting counter (ctr),
+		compressed first with the codec if there is one (see ANGELITA128_Codec.h)
+	Index (32 bytes per chunk, 36 with the checksum flag, after the last chunk):
+		chunk offset (8), stored length (4), plaintext length before compression (4), IV or counter (16),
+		CRC32C of the chunk's plaintext if the checksum flag is set (4)
+
+	Every chunk but the last holds exactly chunk size bytes of plaintext,
+	so the chunk holding plaintext byte N is N / chunk size.
+*/
+
+#ifndef ANGELITA128_CONTAINER_H
+#define ANGELITA128_CONTAINER_H
+
+#include "ANGELITA128_Exception.h"
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+struct ANGELITA128_ContainerHeader {
+	unsigned char version = 1;
+	unsigned char mode = 0;
+	unsigned char codec = 0;
+	unsigned char flags = 0;
+	std::uint32_t chunkSize = 0;
+	std::uint64_t totalLength = 0;
+	std::uint64_t chunkCount = 0;
+	std::uint64_t indexOffset = 0;
+	std::uint32_t checksum = 0;
+};
+
+struct ANGELITA128_ChunkEntry {
+	std::uint64_t offset = 0;
+	std::uint32_t storedLength = 0;
+	std::uint32_t plainLength = 0;
+	std::array<unsigned char, 16> IV = {};
+	std::uint32_t checksum = 0;
+};
+
+class ANGELITA128_Container {
+public:
+	static const unsigned int HEADER_SIZE = 64;
+	static const unsigned int ENTRY_SIZE = 32;
+	static const unsigned int CHECKSUM_ENTRY_SIZE = 36;
+	static const unsigned char MODE_CBC = 1;
+	static const unsigned char MODE_CTR = 2;
+	static const unsigned char CODEC_NONE = 0;
+	static const unsigned char CODEC_LZ = 1;
+	static const unsigned char FLAG_CHECKSUM = 1;
+	//Room past chunk size a stored chunk can need: the codec's format byte and the cbc padding
+	static const unsigned int CHUNK_SPARE = 32;
+
+	static unsigned char modeNumber(std::string mode);
+	static std::string modeName(unsigned char mode);
+	static unsigned char codecNumber(std::string codec);
+	static std::string codecName(unsigned char codec);
+
+	static ANGELITA128_ContainerHeader readHeader(int fd);
+	static void writeHeader(int fd, const ANGELITA128_ContainerHeader& header);
+	static unsigned int entrySize(const ANGELITA128_ContainerHeader& header);
+	static std::uint32_t plaintextChecksum(const std::vector<ANGELITA128_ChunkEntry>& entries);
+	static std::vector<ANGELITA128_ChunkEntry> readIndex(int fd, const ANGELITA128_ContainerHeader& header);
+	static void writeIndex(int fd, const ANGELITA128_ContainerHeader& header, const std::vector<ANGELITA128_ChunkEntry>& entries);
+	static std::uint64_t compact(int fd, const ANGELITA128_ContainerHeader& header, std::vector<ANGELITA128_ChunkEntry>& entries);
+};
+
+#endif
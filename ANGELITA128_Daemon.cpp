@@ -0,0 +1,525 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 daemon methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 daemon and client methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_Daemon.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+struct ANGELITA128_DaemonConnection {
+	int fd;
+	ANGELITA128_DaemonConnection(int fd) : fd(fd) {}
+	//Jobs hold on to their connection, so its descriptor isn't closed and reused under a reply still to be sent
+	~ANGELITA128_DaemonConnection() { close(this->fd); }
+};
+
+static void putU64(unsigned char* bytes, std::uint64_t value) {
+	for (unsigned int i = 0; i < 8; i++) {
+		bytes[i] = (value >> (8 * i)) & 255;
+	}
+}
+
+static std::uint64_t getU64(const unsigned char* bytes) {
+	std::uint64_t value = 0;
+	for (unsigned int i = 0; i < 8; i++) {
+		value |= (std::uint64_t)bytes[i] << (8 * i);
+	}
+	return value;
+}
+
+static void sendReply(int fd, bool done, std::uint64_t outputLength, const unsigned char* payload, size_t payloadLength) {
+	//A reply that can't be sent is dropped, the client has gone
+	unsigned char reply[ANGELITA128_Daemon::REPLY_SIZE] = {};
+	reply[0] = done ? 0 : 1;
+	putU64(reply + 8, outputLength);
+	payloadLength = std::min<size_t>(payloadLength, ANGELITA128_Daemon::REPLY_SIZE - ANGELITA128_Daemon::REPLY_HEADER);
+	if (payloadLength > 0) {
+		std::memcpy(reply + ANGELITA128_Daemon::REPLY_HEADER, payload, payloadLength);
+	}
+	send(fd, reply, ANGELITA128_Daemon::REPLY_HEADER + payloadLength, MSG_NOSIGNAL);
+}
+
+static void sendFailure(int fd, std::string message) {
+	sendReply(fd, 0, 0, (const unsigned char*)message.data(), message.size());
+}
+
+
+///////////////////
+//Daemon
+///////////////////
+
+ANGELITA128_Daemon::ANGELITA128_Daemon(std::string socketPath, unsigned int threadCount) : socketPath(socketPath) {
+	//Make the listening socket and start the worker pool
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0) {
+			threadCount = 1;
+		}
+	}
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(address.sun_path)) {
+		throw ANGELITA128_Exception("ANGELITA128: Daemon socket path is too long.");
+	}
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+
+	//Only a socket left behind by a daemon that is gone is replaced, never another kind of file
+	struct stat socketStat;
+	if (lstat(socketPath.c_str(), &socketStat) == 0 && S_ISSOCK(socketStat.st_mode)) {
+		unlink(socketPath.c_str());
+	}
+	this->listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (this->listenFd < 0 || bind(this->listenFd, (sockaddr*)&address, sizeof(address)) != 0 ||
+		chmod(socketPath.c_str(), 0600) != 0 || listen(this->listenFd, 64) != 0 || pipe2(this->wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+		if (this->listenFd >= 0) {
+			close(this->listenFd);
+			unlink(socketPath.c_str());
+		}
+		throw ANGELITA128_Exception("ANGELITA128: Could not listen on the daemon socket.");
+	}
+	this->started = std::chrono::steady_clock::now();
+	this->daemonStats.workers = threadCount;
+	for (unsigned int t = 0; t < threadCount; t++) {
+		this->workers.emplace_back(&ANGELITA128_Daemon::work, this);
+	}
+}
+
+ANGELITA128_Daemon::~ANGELITA128_Daemon() {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->stopping = 1;
+	}
+	this->jobsReady.notify_all();
+	for (std::thread& worker : this->workers) {
+		worker.join();
+	}
+	for (ANGELITA128_DaemonJob& job : this->jobs) {
+		close(job.dataFd);
+	}
+	close(this->listenFd);
+	close(this->wakePipe[0]);
+	close(this->wakePipe[1]);
+	unlink(this->socketPath.c_str());
+}
+
+unsigned int ANGELITA128_Daemon::addKey(const ANGELITA128& cipher) {
+	if (!cipher.hasKey()) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to serve it.");
+	}
+	std::lock_guard<std::mutex> guard(this->lock);
+	this->ciphers.push_back(&cipher);
+	return this->ciphers.size() - 1;
+}
+
+void ANGELITA128_Daemon::stop() {
+	//Only a write, so a signal handler may call it
+	char wake = 0;
+	if (write(this->wakePipe[1], &wake, 1) < 0) {
+		return;
+	}
+}
+
+void ANGELITA128_Daemon::run() {
+	//Wait on the socket and every connection at once; requests are read here and queued for the workers
+	std::vector<std::shared_ptr<ANGELITA128_DaemonConnection>> connections;
+	while (1) {
+		std::vector<pollfd> pollFds = { { this->wakePipe[0], POLLIN, 0 }, { this->listenFd, POLLIN, 0 } };
+		for (const auto& connection : connections) {
+			pollFds.push_back({ connection->fd, POLLIN, 0 });
+		}
+		if (poll(pollFds.data(), pollFds.size(), -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw ANGELITA128_Exception("ANGELITA128: Daemon could not wait for requests.");
+		}
+		if (pollFds[0].revents != 0) {
+			char wake;
+			while (read(this->wakePipe[0], &wake, 1) > 0) {
+			}
+			return;
+		}
+		std::vector<std::shared_ptr<ANGELITA128_DaemonConnection>> open;
+		for (size_t c = 0; c < connections.size(); c++) {
+			short events = pollFds[c + 2].revents;
+			if ((events & POLLIN) && this->receive(connections[c])) {
+				open.push_back(connections[c]);
+			}
+			else if (events == 0) {
+				open.push_back(connections[c]);
+			}
+		}
+		if (pollFds[1].revents & POLLIN) {
+			int fd = accept4(this->listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+			if (fd >= 0) {
+				open.push_back(std::make_shared<ANGELITA128_DaemonConnection>(fd));
+			}
+		}
+		connections = std::move(open);
+	}
+}
+
+bool ANGELITA128_Daemon::receive(const std::shared_ptr<ANGELITA128_DaemonConnection>& connection) {
+	//Read one request and queue it, or answer it here if it is for the stats; false once the client has gone
+	unsigned char request[REQUEST_SIZE];
+	alignas(cmsghdr) unsigned char control[CMSG_SPACE(sizeof(int) * 4)];
+	iovec part = { request, REQUEST_SIZE };
+	msghdr message = {};
+	message.msg_iov = &part;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	ssize_t got = recvmsg(connection->fd, &message, MSG_CMSG_CLOEXEC);
+	if (got < 0 && (errno == EINTR || errno == EAGAIN)) {
+		return 1;
+	}
+	if (got <= 0) {
+		return 0;
+	}
+
+	//Keep the first descriptor passed, there should only be one
+	int dataFd = -1;
+	for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+		if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+			size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			for (size_t i = 0; i < count; i++) {
+				int fd;
+				std::memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+				if (dataFd < 0) {
+					dataFd = fd;
+				}
+				else {
+					close(fd);
+				}
+			}
+		}
+	}
+
+	ANGELITA128_DaemonJob job;
+	job.connection = connection;
+	job.dataFd = dataFd;
+	job.operation = request[0];
+	std::uint32_t keyId = request[4] | (request[5] << 8) | (request[6] << 16) | ((std::uint32_t)request[7] << 24);
+	job.length = getU64(request + 8);
+	std::memcpy(job.IV.data(), request + 16, 16);
+	std::string failure;
+	if (got != REQUEST_SIZE || (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+		failure = "ANGELITA128: Daemon request is malformed.";
+	}
+	else if (job.operation == OPERATION_STATS) {
+		ANGELITA128_DaemonStats daemonStats = this->stats();
+		unsigned char payload[64];
+		std::uint64_t fields[8] = { daemonStats.requests, daemonStats.failures, daemonStats.bytes, daemonStats.queueDepth,
+			daemonStats.maxQueueDepth, daemonStats.workers, daemonStats.busyNanoseconds, daemonStats.uptimeNanoseconds };
+		for (unsigned int i = 0; i < 8; i++) {
+			putU64(payload + 8 * i, fields[i]);
+		}
+		sendReply(connection->fd, 1, 0, payload, sizeof(payload));
+	}
+	else if (job.operation != OPERATION_ENCRYPT && job.operation != OPERATION_DECRYPT) {
+		failure = "ANGELITA128: Daemon request has an unknown operation.";
+	}
+	else if (request[1] > (unsigned char)ANGELITA128_Mode::CBC_CTS) {
+		failure = "ANGELITA128: Daemon request has an unknown mode.";
+	}
+	else if (dataFd < 0) {
+		failure = "ANGELITA128: Daemon request came without a shared buffer.";
+	}
+	else {
+		job.mode = (ANGELITA128_Mode)request[1];
+		std::lock_guard<std::mutex> guard(this->lock);
+		if (keyId >= this->ciphers.size()) {
+			failure = "ANGELITA128: Daemon has no key with that id.";
+		}
+		else {
+			job.cipher = this->ciphers[keyId];
+			this->jobs.push_back(std::move(job));
+			this->daemonStats.maxQueueDepth = std::max<std::uint64_t>(this->daemonStats.maxQueueDepth, this->jobs.size());
+			this->jobsReady.notify_one();
+			return 1;
+		}
+	}
+	if (dataFd >= 0) {
+		close(dataFd);
+	}
+	if (!failure.empty()) {
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->daemonStats.requests++;
+		this->daemonStats.failures++;
+		sendFailure(connection->fd, failure);
+	}
+	return 1;
+}
+
+void ANGELITA128_Daemon::work() {
+	//Worker thread: take requests off the queue until the daemon stops
+	while (1) {
+		ANGELITA128_DaemonJob job;
+		{
+			std::unique_lock<std::mutex> guard(this->lock);
+			this->jobsReady.wait(guard, [&]() { return this->stopping || !this->jobs.empty(); });
+			if (this->stopping) {
+				return;
+			}
+			job = std::move(this->jobs.front());
+			this->jobs.pop_front();
+		}
+		auto start = std::chrono::steady_clock::now();
+		this->runJob(job);
+		std::uint64_t busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->daemonStats.busyNanoseconds += busy;
+	}
+}
+
+void ANGELITA128_Daemon::runJob(ANGELITA128_DaemonJob& job) {
+	//Map the client's buffer, encrypt or decrypt it in place and reply with the output length
+	//Only a memfd sealed against shrinking is mapped, so the client can't cut the mapping from under the worker
+	std::string failure;
+	size_t outputLength = 0;
+	void* mapped = MAP_FAILED;
+	size_t mappedSize = 0;
+	try {
+		struct stat bufferStat;
+		int seals = fcntl(job.dataFd, F_GET_SEALS);
+		if (fstat(job.dataFd, &bufferStat) != 0 || seals < 0 || !(seals & F_SEAL_SHRINK)) {
+			throw ANGELITA128_Exception("ANGELITA128: Shared buffer must be a memfd sealed against shrinking.");
+		}
+		mappedSize = bufferStat.st_size;
+		if (job.length > mappedSize) {
+			throw ANGELITA128_Exception("ANGELITA128: Length is past the end of the shared buffer.");
+		}
+		std::span<std::uint8_t> buffer;
+		if (mappedSize > 0) {
+			mapped = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, job.dataFd, 0);
+			if (mapped == MAP_FAILED) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not map the shared buffer.");
+			}
+			buffer = std::span<std::uint8_t>((std::uint8_t*)mapped, mappedSize);
+		}
+		if (job.operation == OPERATION_ENCRYPT) {
+			outputLength = job.cipher->encryptInPlace(buffer, job.length, job.mode, job.IV);
+		}
+		else {
+			outputLength = job.cipher->decryptInPlace(buffer.first(job.length), job.mode, job.IV);
+		}
+	}
+	catch (ANGELITA128_Exception& e) {
+		failure = e.what();
+	}
+	if (mapped != MAP_FAILED) {
+		munmap(mapped, mappedSize);
+	}
+	close(job.dataFd);
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->daemonStats.requests++;
+		this->daemonStats.failures += !failure.empty();
+		this->daemonStats.bytes += failure.empty() ? job.length : 0;
+	}
+	if (failure.empty()) {
+		sendReply(job.connection->fd, 1, outputLength, nullptr, 0);
+	}
+	else {
+		sendFailure(job.connection->fd, failure);
+	}
+}
+
+ANGELITA128_DaemonStats ANGELITA128_Daemon::stats() {
+	std::lock_guard<std::mutex> guard(this->lock);
+	ANGELITA128_DaemonStats daemonStats = this->daemonStats;
+	daemonStats.queueDepth = this->jobs.size();
+	daemonStats.uptimeNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->started).count();
+	return daemonStats;
+}
+
+void ANGELITA128_Daemon::showStats(const ANGELITA128_DaemonStats& daemonStats) {
+	//Output the daemon figures to the console
+	double seconds = daemonStats.uptimeNanoseconds / 1e9;
+	std::cout << "Requests: " << daemonStats.requests << " (" << daemonStats.failures << " failed), bytes: " << daemonStats.bytes;
+	if (seconds > 0) {
+		std::cout << " (" << (std::uint64_t)(daemonStats.bytes / seconds) << " bytes/s over " << seconds << " s)";
+	}
+	std::cout << ", queue depth: " << daemonStats.queueDepth << " (most " << daemonStats.maxQueueDepth << ")";
+	if (seconds > 0 && daemonStats.workers > 0) {
+		std::cout << ", " << daemonStats.workers << " workers " << (int)(100 * daemonStats.busyNanoseconds / 1e9 / seconds / daemonStats.workers) << "% busy";
+	}
+	std::cout << "\n";
+}
+
+
+///////////////////
+//Shared buffer
+///////////////////
+
+ANGELITA128_SharedBuffer::ANGELITA128_SharedBuffer(size_t size) : bufferSize(size) {
+	//A memfd of size bytes, sealed so it can't shrink while the daemon has it mapped
+	this->fd = memfd_create("ANGELITA128", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (this->fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not make a shared buffer.");
+	}
+	if (ftruncate(this->fd, size) != 0 || fcntl(this->fd, F_ADD_SEALS, F_SEAL_SHRINK) != 0) {
+		close(this->fd);
+		throw ANGELITA128_Exception("ANGELITA128: Could not make a shared buffer.");
+	}
+	if (size > 0) {
+		void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+		if (mapped == MAP_FAILED) {
+			close(this->fd);
+			throw ANGELITA128_Exception("ANGELITA128: Could not map a shared buffer.");
+		}
+		this->bytes = (unsigned char*)mapped;
+	}
+}
+
+ANGELITA128_SharedBuffer::~ANGELITA128_SharedBuffer() {
+	if (this->bytes != nullptr) {
+		munmap(this->bytes, this->bufferSize);
+	}
+	close(this->fd);
+}
+
+
+///////////////////
+//Client
+///////////////////
+
+ANGELITA128_DaemonClient::ANGELITA128_DaemonClient(std::string socketPath) {
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(address.sun_path)) {
+		throw ANGELITA128_Exception("ANGELITA128: Daemon socket path is too long.");
+	}
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+	this->socketFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (this->socketFd < 0 || connect(this->socketFd, (sockaddr*)&address, sizeof(address)) != 0) {
+		if (this->socketFd >= 0) {
+			close(this->socketFd);
+		}
+		throw ANGELITA128_Exception("ANGELITA128: Could not connect to the daemon.");
+	}
+}
+
+ANGELITA128_DaemonClient::~ANGELITA128_DaemonClient() {
+	close(this->socketFd);
+}
+
+std::vector<unsigned char> ANGELITA128_DaemonClient::request(unsigned char operation, ANGELITA128_Mode mode, unsigned int keyId,
+	std::uint64_t length, const std::array<unsigned char, 16>& IV, int dataFd) {
+	//Send one request, with the buffer's descriptor if there is one, and wait for its reply
+	unsigned char request[ANGELITA128_Daemon::REQUEST_SIZE] = {};
+	request[0] = operation;
+	request[1] = (unsigned char)mode;
+	for (unsigned int i = 0; i < 4; i++) {
+		request[4 + i] = (keyId >> (8 * i)) & 255;
+	}
+	putU64(request + 8, length);
+	std::memcpy(request + 16, IV.data(), 16);
+
+	iovec part = { request, sizeof(request) };
+	msghdr message = {};
+	message.msg_iov = &part;
+	message.msg_iovlen = 1;
+	alignas(cmsghdr) unsigned char control[CMSG_SPACE(sizeof(int))] = {};
+	if (dataFd >= 0) {
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		cmsghdr* header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(sizeof(int));
+		std::memcpy(CMSG_DATA(header), &dataFd, sizeof(int));
+	}
+
+	std::lock_guard<std::mutex> guard(this->lock);
+	if (sendmsg(this->socketFd, &message, MSG_NOSIGNAL) != (ssize_t)sizeof(request)) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not send the request to the daemon.");
+	}
+	std::vector<unsigned char> reply(ANGELITA128_Daemon::REPLY_SIZE);
+	ssize_t got;
+	do {
+		got = recv(this->socketFd, reply.data(), reply.size(), 0);
+	} while (got < 0 && errno == EINTR);
+	if (got < (ssize_t)ANGELITA128_Daemon::REPLY_HEADER) {
+		throw ANGELITA128_Exception("ANGELITA128: Daemon closed the connection.");
+	}
+	reply.resize(got);
+	if (reply[0] != 0) {
+		throw ANGELITA128_Exception(std::string(reply.begin() + ANGELITA128_Daemon::REPLY_HEADER, reply.end()));
+	}
+	return reply;
+}
+
+size_t ANGELITA128_DaemonClient::encrypt(ANGELITA128_SharedBuffer& buffer, size_t length, unsigned int keyId, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) {
+	if (length > buffer.size()) {
+		throw ANGELITA128_Exception("ANGELITA128: Plaintext length is longer than the buffer.");
+	}
+	std::vector<unsigned char> reply = this->request(ANGELITA128_Daemon::OPERATION_ENCRYPT, mode, keyId, length, IV, buffer.descriptor());
+	return getU64(reply.data() + 8);
+}
+
+size_t ANGELITA128_DaemonClient::decrypt(ANGELITA128_SharedBuffer& buffer, size_t length, unsigned int keyId, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV) {
+	if (length > buffer.size()) {
+		throw ANGELITA128_Exception("ANGELITA128: Ciphertext length is longer than the buffer.");
+	}
+	std::vector<unsigned char> reply = this->request(ANGELITA128_Daemon::OPERATION_DECRYPT, mode, keyId, length, IV, buffer.descriptor());
+	return getU64(reply.data() + 8);
+}
+
+ANGELITA128_DaemonStats ANGELITA128_DaemonClient::stats() {
+	std::vector<unsigned char> reply = this->request(ANGELITA128_Daemon::OPERATION_STATS, ANGELITA128_Mode::ECB, 0, 0, {}, -1);
+	if (reply.size() < ANGELITA128_Daemon::REPLY_HEADER + 64) {
+		throw ANGELITA128_Exception("ANGELITA128: Daemon stats reply is malformed.");
+	}
+	const unsigned char* fields = reply.data() + ANGELITA128_Daemon::REPLY_HEADER;
+	ANGELITA128_DaemonStats daemonStats;
+	daemonStats.requests = getU64(fields);
+	daemonStats.failures = getU64(fields + 8);
+	daemonStats.bytes = getU64(fields + 16);
+	daemonStats.queueDepth = getU64(fields + 24);
+	daemonStats.maxQueueDepth = getU64(fields + 32);
+	daemonStats.workers = getU64(fields + 40);
+	daemonStats.busyNanoseconds = getU64(fields + 48);
+	daemonStats.uptimeNanoseconds = getU64(fields + 56);
+	return daemonStats;
+}
@@ -0,0 +1,167 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 daemon header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 daemon and client classes
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+/*
+	Daemon protocol, over a Unix domain SOCK_SEQPACKET socket, one message per packet, numbers little endian:
+
+	Request (32 bytes): operation (1 encrypt, 2 decrypt, 3 stats), mode (ANGELITA128_Mode), reserved (2),
+		key id (4), length (8), IV (16)
+		encrypt and decrypt pass a memfd with SCM_RIGHTS holding the data at its start, sealed against shrinking;
+		the daemon maps it and works on it in place, so the data itself never goes through the socket
+	Reply: result (1, 0 done), reserved (7), output length (8), then an error message,
+		or for stats the ANGELITA128_DaemonStats fields, 8 bytes each in order
+
+	A client has one request out at a time; use more than one client for more at once.
+*/
+
+#ifndef ANGELITA128_DAEMON_H
+#define ANGELITA128_DAEMON_H
+
+#include "ANGELITA128.h"
+#include <deque>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+struct ANGELITA128_DaemonStats {
+	std::uint64_t requests = 0;
+	std::uint64_t failures = 0;
+	std::uint64_t bytes = 0;
+	std::uint64_t queueDepth = 0;
+	std::uint64_t maxQueueDepth = 0;
+	std::uint64_t workers = 0;
+	std::uint64_t busyNanoseconds = 0;
+	std::uint64_t uptimeNanoseconds = 0;
+};
+
+struct ANGELITA128_DaemonConnection;
+
+struct ANGELITA128_DaemonJob {
+	std::shared_ptr<ANGELITA128_DaemonConnection> connection;
+	int dataFd = -1;
+	unsigned char operation = 0;
+	ANGELITA128_Mode mode = ANGELITA128_Mode::CBC;
+	const ANGELITA128* cipher = nullptr;
+	std::uint64_t length = 0;
+	std::array<unsigned char, 16> IV = {};
+};
+
+class ANGELITA128_Daemon {
+private:
+	std::string socketPath;
+	int listenFd = -1;
+	int wakePipe[2] = { -1, -1 };
+	std::vector<const ANGELITA128*> ciphers;
+
+	//Requests wait in the queue for the worker pool
+	std::mutex lock;
+	std::condition_variable jobsReady;
+	std::deque<ANGELITA128_DaemonJob> jobs;
+	std::vector<std::thread> workers;
+	bool stopping = 0;
+	ANGELITA128_DaemonStats daemonStats;
+	std::chrono::steady_clock::time_point started;
+
+	void work();
+	void runJob(ANGELITA128_DaemonJob& job);
+	//Read a request off a connection, false once the client has hung up
+	bool receive(const std::shared_ptr<ANGELITA128_DaemonConnection>& connection);
+
+public:
+	static const unsigned int REQUEST_SIZE = 32;
+	static const unsigned int REPLY_HEADER = 16;
+	static const unsigned int REPLY_SIZE = 272;
+	static const unsigned char OPERATION_ENCRYPT = 1;
+	static const unsigned char OPERATION_DECRYPT = 2;
+	static const unsigned char OPERATION_STATS = 3;
+
+	//Listens on socketPath, replacing a stale socket there, readable and writable by this user only
+	//threadCount workers (0 for one per core) run the requests
+	ANGELITA128_Daemon(std::string socketPath, unsigned int threadCount = 0);
+	~ANGELITA128_Daemon();
+	ANGELITA128_Daemon(const ANGELITA128_Daemon&) = delete;
+	ANGELITA128_Daemon& operator=(const ANGELITA128_Daemon&) = delete;
+
+	//Serve a keyed cipher, returns the key id clients ask for it by; it must outlive the daemon
+	//The workers share it, which is safe as they only use the keyed state
+	unsigned int addKey(const ANGELITA128& cipher);
+	//Serve requests until stop(), which is safe to call from a signal handler
+	void run();
+	void stop();
+	ANGELITA128_DaemonStats stats();
+	static void showStats(const ANGELITA128_DaemonStats& daemonStats);
+};
+
+//Memory shared with the daemon: a sealed memfd mapped into this process
+class ANGELITA128_SharedBuffer {
+private:
+	int fd = -1;
+	unsigned char* bytes = nullptr;
+	size_t bufferSize = 0;
+
+public:
+	ANGELITA128_SharedBuffer(size_t size);
+	~ANGELITA128_SharedBuffer();
+	ANGELITA128_SharedBuffer(const ANGELITA128_SharedBuffer&) = delete;
+	ANGELITA128_SharedBuffer& operator=(const ANGELITA128_SharedBuffer&) = delete;
+
+	unsigned char* data() { return this->bytes; }
+	size_t size() const { return this->bufferSize; }
+	int descriptor() const { return this->fd; }
+};
+
+class ANGELITA128_DaemonClient {
+private:
+	int socketFd = -1;
+	std::mutex lock;
+
+	std::vector<unsigned char> request(unsigned char operation, ANGELITA128_Mode mode, unsigned int keyId, std::uint64_t length,
+		const std::array<unsigned char, 16>& IV, int dataFd);
+
+public:
+	ANGELITA128_DaemonClient(std::string socketPath);
+	~ANGELITA128_DaemonClient();
+	ANGELITA128_DaemonClient(const ANGELITA128_DaemonClient&) = delete;
+	ANGELITA128_DaemonClient& operator=(const ANGELITA128_DaemonClient&) = delete;
+
+	//Encrypt or decrypt the first length bytes of buffer in place with the daemon's key keyId, like encryptInPlace/decryptInPlace
+	//Returns the output length; encrypting needs ANGELITA128::encryptedSize() bytes of buffer
+	size_t encrypt(ANGELITA128_SharedBuffer& buffer, size_t length, unsigned int keyId, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV);
+	size_t decrypt(ANGELITA128_SharedBuffer& buffer, size_t length, unsigned int keyId, ANGELITA128_Mode mode, std::array<unsigned char, 16> IV);
+	ANGELITA128_DaemonStats stats();
+};
+
+#endif
@@ -43,7 +43,7 @@ private:
 	std::string errorMessage;
 public:
 	ANGELITA128_Exception(std::string errMessage) : errorMessage(errMessage) {}
-	virtual const char* what() { return errorMessage.c_str(); }
+	const char* what() const noexcept override { return errorMessage.c_str(); }
 };
 
 #endif
\ No newline at end of file
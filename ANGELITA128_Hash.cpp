@@ -0,0 +1,210 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 tree hash methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 tree hash methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include "ANGELITA128_IO.h"
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+//The fingerprint is a Merkle tree over leaves of LEAF_SIZE bytes, every step an encryption under this object's key:
+//	leaf i:	h = E(D(1, i)), then h = E(h ^ m) for each block m of the leaf,
+//		the last leaf holding what is left (maybe nothing) padded with 0x80 and zeros to whole blocks
+//	node:	E(E(D(2, level) ^ left) ^ right), an odd node at the end of a level moves up as it is
+//	root:	E(E(D(3, total length)) ^ top node)
+//where D(domain, n) is the block with the domain in byte 0 and n big endian in bytes 8 to 15.
+//Leaves don't depend on each other, so they go through the lanes side by side and the lane groups over threads.
+//With a fixed public key a 128-bit block cipher can't make a collision resistant hash, so the key is the caller's:
+//the fingerprint is a PRF of the data, like a MAC, and only someone with the key can make or check one.
+
+static const size_t LEAF_SIZE = 65536;
+static const size_t LEAF_BLOCKS = LEAF_SIZE / 16;
+
+static std::array<unsigned char, 16> domainBlock(unsigned char domain, std::uint64_t value) {
+	std::array<unsigned char, 16> block = {};
+	block[0] = domain;
+	for (unsigned int i = 0; i < 8; i++) {
+		block[15 - i] = (value >> (8 * i)) & 255;
+	}
+	return block;
+}
+
+void ANGELITA128::hashLeaves(const unsigned char* data, std::uint64_t firstLeaf, size_t leafCount, std::array<unsigned char, 16>* hashes) const {
+	//Hash whole leaves, one per lane, each lane chaining through its own leaf a block at a time
+	unsigned char laneBlocks[256];
+	for (size_t group = 0; group < leafCount; group += this->laneCount) {
+		unsigned int lanes = leafCount - group < this->laneCount ? leafCount - group : this->laneCount;
+		for (unsigned int lane = 0; lane < lanes; lane++) {
+			std::array<unsigned char, 16> start = domainBlock(1, firstLeaf + group + lane);
+			std::memcpy(laneBlocks + lane * 16, start.data(), 16);
+		}
+		this->encryptLanes(laneBlocks, lanes);
+		const unsigned char* leaves = data + group * LEAF_SIZE;
+		for (size_t block = 0; block < LEAF_BLOCKS; block++) {
+			for (unsigned int lane = 0; lane < lanes; lane++) {
+				const unsigned char* input = leaves + lane * LEAF_SIZE + block * 16;
+				for (unsigned int i = 0; i < 16; i++) {
+					laneBlocks[lane * 16 + i] ^= input[i];
+				}
+			}
+			this->encryptLanes(laneBlocks, lanes);
+		}
+		for (unsigned int lane = 0; lane < lanes; lane++) {
+			std::memcpy(hashes[group + lane].data(), laneBlocks + lane * 16, 16);
+		}
+	}
+}
+
+std::array<unsigned char, 16> ANGELITA128::hashLastLeaf(const unsigned char* data, size_t length, std::uint64_t leaf) const {
+	//Hash the short last leaf, padded, on its own
+	std::array<unsigned char, 16> hash = domainBlock(1, leaf);
+	this->encryptLanes(hash.data(), 1);
+	size_t blocks = length / 16 + 1;
+	for (size_t block = 0; block < blocks; block++) {
+		unsigned char input[16] = {};
+		size_t take = block * 16 + 16 <= length ? 16 : length - block * 16;
+		if (take > 0) {
+			std::memcpy(input, data + block * 16, take);
+		}
+		if (take < 16) {
+			input[take] = 0x80;
+		}
+		for (unsigned int i = 0; i < 16; i++) {
+			hash[i] ^= input[i];
+		}
+		this->encryptLanes(hash.data(), 1);
+	}
+	return hash;
+}
+
+std::array<unsigned char, 16> ANGELITA128::hashTree(std::vector<std::array<unsigned char, 16>> nodes, std::uint64_t totalLength) const {
+	//Hash the leaf hashes up the tree a level at a time, then bind the total length in at the root
+	for (std::uint64_t level = 0; nodes.size() > 1; level++) {
+		std::array<unsigned char, 16> start = domainBlock(2, level);
+		this->encryptLanes(start.data(), 1);
+		std::vector<std::array<unsigned char, 16>> parents((nodes.size() + 1) / 2);
+		for (size_t p = 0; p < nodes.size() / 2; p++) {
+			std::array<unsigned char, 16> node = start;
+			for (unsigned int i = 0; i < 16; i++) {
+				node[i] ^= nodes[2 * p][i];
+			}
+			this->encryptLanes(node.data(), 1);
+			for (unsigned int i = 0; i < 16; i++) {
+				node[i] ^= nodes[2 * p + 1][i];
+			}
+			this->encryptLanes(node.data(), 1);
+			parents[p] = node;
+		}
+		if (nodes.size() % 2 == 1) {
+			parents.back() = nodes.back();
+		}
+		nodes = std::move(parents);
+	}
+	std::array<unsigned char, 16> root = domainBlock(3, totalLength);
+	this->encryptLanes(root.data(), 1);
+	for (unsigned int i = 0; i < 16; i++) {
+		root[i] ^= nodes[0][i];
+	}
+	this->encryptLanes(root.data(), 1);
+	return root;
+}
+
+
+///////////////////
+//Fingerprint interface
+///////////////////
+
+std::array<unsigned char, 16> ANGELITA128::fingerprint(std::span<const std::uint8_t> data, unsigned int threadCount) const {
+	//Fingerprint data in memory, the whole leaves a lane group per task over the threads
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to fingerprint.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+	std::uint64_t wholeLeaves = data.size() / LEAF_SIZE;
+	std::vector<std::array<unsigned char, 16>> leaves(wholeLeaves + 1);
+	size_t groups = (wholeLeaves + this->laneCount - 1) / this->laneCount;
+	parallelFor(groups, threadCount, [&](size_t group) {
+		std::uint64_t first = group * this->laneCount;
+		size_t count = std::min<std::uint64_t>(this->laneCount, wholeLeaves - first);
+		this->hashLeaves(data.data() + first * LEAF_SIZE, first, count, leaves.data() + first);
+	});
+	leaves.back() = this->hashLastLeaf(data.data() + wholeLeaves * LEAF_SIZE, data.size() % LEAF_SIZE, wholeLeaves);
+	return this->hashTree(std::move(leaves), data.size());
+}
+
+std::array<unsigned char, 16> ANGELITA128::fingerprintFile(std::string file, unsigned int threadCount) const {
+	//Fingerprint a file of any size, read a batch of lane groups at a time, one group per thread
+	if (!this->keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to fingerprint.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file to fingerprint.");
+	}
+	std::array<unsigned char, 16> result;
+	try {
+		struct stat fileStat;
+		fstat(fd, &fileStat);
+		std::uint64_t totalLength = fileStat.st_size;
+		std::uint64_t wholeLeaves = totalLength / LEAF_SIZE;
+		std::vector<std::array<unsigned char, 16>> leaves(wholeLeaves + 1);
+		size_t batchLeaves = (size_t)threadCount * this->laneCount;
+		std::vector<unsigned char> batch(std::min<std::uint64_t>(batchLeaves, wholeLeaves + 1) * LEAF_SIZE);
+		for (std::uint64_t batchStart = 0; batchStart < wholeLeaves; batchStart += batchLeaves) {
+			size_t count = std::min<std::uint64_t>(batchLeaves, wholeLeaves - batchStart);
+			ANGELITA128_IO::readAt(fd, batch.data(), count * LEAF_SIZE, batchStart * LEAF_SIZE);
+			size_t groups = (count + this->laneCount - 1) / this->laneCount;
+			parallelFor(groups, threadCount, [&](size_t group) {
+				size_t first = group * this->laneCount;
+				size_t groupLeaves = count - first < this->laneCount ? count - first : this->laneCount;
+				this->hashLeaves(batch.data() + first * LEAF_SIZE, batchStart + first, groupLeaves, leaves.data() + batchStart + first);
+			});
+		}
+		size_t lastLength = totalLength % LEAF_SIZE;
+		ANGELITA128_IO::readAt(fd, batch.data(), lastLength, wholeLeaves * LEAF_SIZE);
+		leaves.back() = this->hashLastLeaf(batch.data(), lastLength, wholeLeaves);
+		result = this->hashTree(std::move(leaves), totalLength);
+	}
+	catch (...) {
+		close(fd);
+		throw;
+	}
+	close(fd);
+	return result;
+}
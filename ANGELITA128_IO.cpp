@@ -0,0 +1,634 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 file I/O backend methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 I/O backend methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_IO.h"
+#include "ANGELITA128_Arena.h"
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef ANGELITA128_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+static size_t readFull(int fd, unsigned char* buffer, size_t length) {
+	//Read until the buffer is full or the end of the input, pipes can return less each time
+	size_t done = 0;
+	while (done < length) {
+		ssize_t got = read(fd, buffer + done, length - done);
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+		if (got < 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not read input.");
+		}
+		if (got == 0) {
+			break;
+		}
+		done += got;
+	}
+	return done;
+}
+
+static void writeFull(int fd, const unsigned char* buffer, size_t length) {
+	//Write the whole buffer
+	size_t done = 0;
+	while (done < length) {
+		ssize_t put = write(fd, buffer + done, length - done);
+		if (put < 0 && errno == EINTR) {
+			continue;
+		}
+		if (put <= 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not write output.");
+		}
+		done += put;
+	}
+}
+
+static void seekTo(int fd, std::uint64_t offset) {
+	//Position the file, pipes and terminals can't seek and are read or written as they are
+	if (lseek(fd, offset, SEEK_SET) < 0 && errno != ESPIPE) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not seek in file.");
+	}
+}
+
+size_t ANGELITA128_IO::readAll(int fd, unsigned char* buffer, size_t length) {
+	return readFull(fd, buffer, length);
+}
+
+void ANGELITA128_IO::writeAll(int fd, const unsigned char* buffer, size_t length) {
+	writeFull(fd, buffer, length);
+}
+
+void ANGELITA128_IO::readAt(int fd, unsigned char* buffer, size_t length, std::uint64_t offset) {
+	size_t done = 0;
+	while (done < length) {
+		ssize_t got = pread(fd, buffer + done, length - done, offset + done);
+		if (got < 0 && errno == EINTR) {
+			continue;
+		}
+		if (got <= 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not read file.");
+		}
+		done += got;
+	}
+}
+
+void ANGELITA128_IO::writeAt(int fd, const unsigned char* buffer, size_t length, std::uint64_t offset) {
+	size_t done = 0;
+	while (done < length) {
+		ssize_t put = pwrite(fd, buffer + done, length - done, offset + done);
+		if (put < 0 && errno == EINTR) {
+			continue;
+		}
+		if (put <= 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not write file.");
+		}
+		done += put;
+	}
+}
+
+std::unique_ptr<ANGELITA128_IO> ANGELITA128_IO::create(std::string backend) {
+	//Make the I/O backend by name
+	//"auto" uses io_uring when the kernel allows it, and the blocking backend otherwise
+	if (backend == "blocking") {
+		return std::unique_ptr<ANGELITA128_IO>(new ANGELITA128_BlockingIO());
+	}
+	if (backend == "pipeline") {
+		return std::unique_ptr<ANGELITA128_IO>(new ANGELITA128_PipelineIO());
+	}
+#ifdef ANGELITA128_IO_URING
+	if (backend == "io_uring") {
+		return std::unique_ptr<ANGELITA128_IO>(new ANGELITA128_UringIO());
+	}
+	if (backend == "auto") {
+		try {
+			return std::unique_ptr<ANGELITA128_IO>(new ANGELITA128_UringIO());
+		}
+		catch (ANGELITA128_Exception& err) {
+			return std::unique_ptr<ANGELITA128_IO>(new ANGELITA128_PipelineIO());
+		}
+	}
+#else
+	if (backend == "io_uring") {
+		throw ANGELITA128_Exception("ANGELITA128: The io_uring backend is not available on this system.");
+	}
+	if (backend == "auto") {
+		return std::unique_ptr<ANGELITA128_IO>(new ANGELITA128_PipelineIO());
+	}
+#endif
+	throw ANGELITA128_Exception("ANGELITA128: Invalid I/O backend, must be \"auto\", \"blocking\", \"pipeline\" or \"io_uring\".");
+}
+
+
+///////////////////
+//Blocking backend
+///////////////////
+
+void ANGELITA128_BlockingIO::run(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, size_t chunkSize, ANGELITA128_ChunkTransform transform) {
+	//Read a chunk ahead so the transform knows which chunk is the last one, works on pipes as well as files
+	seekTo(inputFd, inputOffset);
+	seekTo(outputFd, outputOffset);
+	ANGELITA128_ArenaBuffer current(chunkSize + 16);
+	ANGELITA128_ArenaBuffer next(chunkSize + 16);
+	size_t currentLength = readFull(inputFd, current.data(), chunkSize);
+	for (;;) {
+		size_t nextLength = 0;
+		if (currentLength == chunkSize) {
+			nextLength = readFull(inputFd, next.data(), chunkSize);
+		}
+		bool lastChunk = nextLength == 0;
+		size_t outputLength = transform(current.data(), currentLength, lastChunk);
+		writeFull(outputFd, current.data(), outputLength);
+		if (lastChunk) {
+			break;
+		}
+		std::swap(current, next);
+		currentLength = nextLength;
+	}
+}
+
+
+///////////////////
+//Pipeline backend
+///////////////////
+
+ANGELITA128_PipelineIO::ANGELITA128_PipelineIO(unsigned int ringSize) : ringSize(ringSize) {
+	//The cipher looks one chunk ahead to find the last chunk, so the ring needs at least 2 buffers
+	if (this->ringSize < 2) {
+		this->ringSize = 2;
+	}
+}
+
+void ANGELITA128_PipelineIO::run(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, size_t chunkSize, ANGELITA128_ChunkTransform transform) {
+	//Chunk k always uses buffer k % ringSize, and each stage goes through the chunks in order:
+	//the reader fills empty buffers, the cipher transforms filled ones, the writer empties transformed ones.
+	//With serial modes like cbc encryption the cipher only ever waits when the disk is the slower side.
+	seekTo(inputFd, inputOffset);
+	seekTo(outputFd, outputOffset);
+
+	enum SlotState { EMPTY, FILLED, TRANSFORMED };
+	struct Slot {
+		ANGELITA128_ArenaBuffer buffer;
+		SlotState state = EMPTY;
+		size_t length = 0;
+		bool lastChunk = 0;
+	};
+	std::vector<Slot> slots(this->ringSize);
+	for (unsigned int i = 0; i < slots.size(); i++) {
+		slots[i].buffer = ANGELITA128_ArenaBuffer(chunkSize + 16);
+	}
+	std::mutex lock;
+	std::condition_variable changed;
+	std::exception_ptr failure;
+	bool failed = 0;
+	//Set by the reader once it has found the end, as the number of chunks
+	std::uint64_t chunkCount = UINT64_MAX;
+
+	auto fail = [&]() {
+		std::lock_guard<std::mutex> guard(lock);
+		if (!failed) {
+			failure = std::current_exception();
+			failed = 1;
+		}
+		changed.notify_all();
+	};
+
+	std::thread reader([&]() {
+		try {
+			for (std::uint64_t chunk = 0;; chunk++) {
+				Slot& slot = slots[chunk % slots.size()];
+				{
+					std::unique_lock<std::mutex> guard(lock);
+					changed.wait(guard, [&]() { return failed || slot.state == EMPTY; });
+					if (failed) {
+						return;
+					}
+				}
+				size_t length = readFull(inputFd, slot.buffer.data(), chunkSize);
+				std::lock_guard<std::mutex> guard(lock);
+				if (length == 0 && chunk > 0) {
+					//The previous chunk was full and turned out to be the last one
+					chunkCount = chunk;
+					changed.notify_all();
+					return;
+				}
+				slot.length = length;
+				slot.state = FILLED;
+				if (length < chunkSize) {
+					chunkCount = chunk + 1;
+				}
+				changed.notify_all();
+				if (length < chunkSize) {
+					return;
+				}
+			}
+		}
+		catch (...) {
+			fail();
+		}
+	});
+
+	std::thread writer([&]() {
+		try {
+			for (std::uint64_t chunk = 0;; chunk++) {
+				Slot& slot = slots[chunk % slots.size()];
+				{
+					std::unique_lock<std::mutex> guard(lock);
+					changed.wait(guard, [&]() { return failed || slot.state == TRANSFORMED; });
+					if (failed) {
+						return;
+					}
+				}
+				writeFull(outputFd, slot.buffer.data(), slot.length);
+				std::lock_guard<std::mutex> guard(lock);
+				slot.state = EMPTY;
+				changed.notify_all();
+				if (slot.lastChunk) {
+					return;
+				}
+			}
+		}
+		catch (...) {
+			fail();
+		}
+	});
+
+	try {
+		for (std::uint64_t chunk = 0;; chunk++) {
+			Slot& slot = slots[chunk % slots.size()];
+			Slot& nextSlot = slots[(chunk + 1) % slots.size()];
+			bool lastChunk;
+			{
+				//Wait for this chunk, and for the next one or the end so the last chunk is known
+				std::unique_lock<std::mutex> guard(lock);
+				changed.wait(guard, [&]() {
+					return failed || (slot.state == FILLED && (chunkCount <= chunk + 1 || nextSlot.state == FILLED));
+				});
+				if (failed) {
+					break;
+				}
+				lastChunk = chunkCount <= chunk + 1;
+			}
+			size_t outputLength = transform(slot.buffer.data(), slot.length, lastChunk);
+			std::lock_guard<std::mutex> guard(lock);
+			slot.length = outputLength;
+			slot.lastChunk = lastChunk;
+			slot.state = TRANSFORMED;
+			changed.notify_all();
+			if (lastChunk) {
+				break;
+			}
+		}
+	}
+	catch (...) {
+		fail();
+	}
+	reader.join();
+	writer.join();
+	if (failure) {
+		std::rethrow_exception(failure);
+	}
+}
+
+
+///////////////////
+//io_uring backend
+///////////////////
+
+#ifdef ANGELITA128_IO_URING
+
+ANGELITA128_UringIO::ANGELITA128_UringIO(unsigned int queueDepth) : queueDepth(queueDepth) {
+	//Set up the submission and completion rings
+	struct io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	this->ringFd = syscall(__NR_io_uring_setup, queueDepth, &params);
+	if (this->ringFd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: io_uring is not available.");
+	}
+
+	this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if (singleMap) {
+		this->sqRingSize = std::max(this->sqRingSize, this->cqRingSize);
+	}
+	this->sqRing = mmap(nullptr, this->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_SQ_RING);
+	if (this->sqRing == MAP_FAILED) {
+		this->sqRing = nullptr;
+		this->closeRing();
+		throw ANGELITA128_Exception("ANGELITA128: io_uring is not available.");
+	}
+	if (singleMap) {
+		this->cqRing = this->sqRing;
+		this->cqRingSize = 0;
+	}
+	else {
+		this->cqRing = mmap(nullptr, this->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_CQ_RING);
+	}
+	this->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	this->sqes = mmap(nullptr, this->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_SQES);
+	if (this->cqRing == MAP_FAILED || this->sqes == MAP_FAILED) {
+		if (this->cqRing == MAP_FAILED) {
+			this->cqRing = nullptr;
+		}
+		if (this->sqes == MAP_FAILED) {
+			this->sqes = nullptr;
+		}
+		this->closeRing();
+		throw ANGELITA128_Exception("ANGELITA128: io_uring is not available.");
+	}
+
+	char* sq = (char*)this->sqRing;
+	char* cq = (char*)this->cqRing;
+	this->sqHead = (unsigned int*)(sq + params.sq_off.head);
+	this->sqTail = (unsigned int*)(sq + params.sq_off.tail);
+	this->sqMask = (unsigned int*)(sq + params.sq_off.ring_mask);
+	this->sqArray = (unsigned int*)(sq + params.sq_off.array);
+	this->cqHead = (unsigned int*)(cq + params.cq_off.head);
+	this->cqTail = (unsigned int*)(cq + params.cq_off.tail);
+	this->cqMask = (unsigned int*)(cq + params.cq_off.ring_mask);
+	this->cqes = cq + params.cq_off.cqes;
+}
+
+ANGELITA128_UringIO::~ANGELITA128_UringIO() {
+	this->closeRing();
+}
+
+void ANGELITA128_UringIO::closeRing() {
+	//Unmap the rings and close the ring descriptor
+	if (this->sqes) {
+		munmap(this->sqes, this->sqesSize);
+		this->sqes = nullptr;
+	}
+	if (this->cqRing && this->cqRing != this->sqRing) {
+		munmap(this->cqRing, this->cqRingSize);
+	}
+	this->cqRing = nullptr;
+	if (this->sqRing) {
+		munmap(this->sqRing, this->sqRingSize);
+		this->sqRing = nullptr;
+	}
+	if (this->ringFd >= 0) {
+		close(this->ringFd);
+		this->ringFd = -1;
+	}
+}
+
+void ANGELITA128_UringIO::submit(unsigned char opcode, int fd, unsigned char* buffer, unsigned int length, std::uint64_t offset, int bufferIndex, std::uint64_t userData) {
+	//Queue one read or write, it goes to the kernel with the next waitCompletion
+	unsigned int tail = *this->sqTail;
+	unsigned int index = tail & *this->sqMask;
+	struct io_uring_sqe* sqe = (struct io_uring_sqe*)this->sqes + index;
+	std::memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = (std::uint64_t)(uintptr_t)buffer;
+	sqe->len = length;
+	sqe->off = offset;
+	sqe->user_data = userData;
+	if (bufferIndex >= 0) {
+		sqe->buf_index = bufferIndex;
+	}
+	this->sqArray[index] = index;
+	__atomic_store_n(this->sqTail, tail + 1, __ATOMIC_RELEASE);
+	this->pendingSubmits++;
+}
+
+void ANGELITA128_UringIO::waitCompletion(std::uint64_t& userData, int& result) {
+	//Hand the queued operations to the kernel and take the next completion
+	for (;;) {
+		unsigned int head = *this->cqHead;
+		bool completionReady = head != __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE);
+		if (this->pendingSubmits > 0 || !completionReady) {
+			int submitted = syscall(__NR_io_uring_enter, this->ringFd, this->pendingSubmits, completionReady ? 0 : 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (submitted < 0) {
+				if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+					continue;
+				}
+				throw ANGELITA128_Exception("ANGELITA128: io_uring submit failed.");
+			}
+			this->pendingSubmits -= submitted;
+			continue;
+		}
+		struct io_uring_cqe* cqe = (struct io_uring_cqe*)this->cqes + (head & *this->cqMask);
+		userData = cqe->user_data;
+		result = cqe->res;
+		__atomic_store_n(this->cqHead, head + 1, __ATOMIC_RELEASE);
+		return;
+	}
+}
+
+void ANGELITA128_UringIO::run(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, size_t chunkSize, ANGELITA128_ChunkTransform transform) {
+	//Keep up to queueDepth chunks in flight: reads fill buffers ahead of the cipher,
+	//the cipher transforms the chunks in order as they arrive, and writes drain behind it.
+	//A buffer is refilled with the next unread chunk as soon as its write finishes.
+	struct stat inputStat;
+	struct stat outputStat;
+	if (fstat(inputFd, &inputStat) != 0 || fstat(outputFd, &outputStat) != 0 || !S_ISREG(inputStat.st_mode) || !S_ISREG(outputStat.st_mode)) {
+		//Pipes and devices have no offsets to queue against, the pipeline still overlaps them with the cipher
+		ANGELITA128_PipelineIO().run(inputFd, inputOffset, outputFd, outputOffset, chunkSize, transform);
+		return;
+	}
+	std::uint64_t inputLength = (std::uint64_t)inputStat.st_size > inputOffset ? inputStat.st_size - inputOffset : 0;
+	if (inputLength == 0) {
+		ANGELITA128_BlockingIO().run(inputFd, inputOffset, outputFd, outputOffset, chunkSize, transform);
+		return;
+	}
+
+	std::uint64_t chunkCount = (inputLength + chunkSize - 1) / chunkSize;
+	unsigned int bufferCount = std::min<std::uint64_t>(this->queueDepth, chunkCount);
+	size_t bufferSize = chunkSize + 16;
+	size_t storageSize = (bufferSize * bufferCount + 4095) / 4096 * 4096;
+	ANGELITA128_ArenaBuffer storageBuffer(storageSize);
+	unsigned char* storage = storageBuffer.data();
+
+	//Registered buffers save the kernel mapping the pages on every operation,
+	//locked memory limits can refuse them, in which case plain reads and writes are used
+	std::vector<struct iovec> iovecs(bufferCount);
+	for (unsigned int b = 0; b < bufferCount; b++) {
+		iovecs[b].iov_base = storage + b * bufferSize;
+		iovecs[b].iov_len = bufferSize;
+	}
+	bool fixedBuffers = syscall(__NR_io_uring_register, this->ringFd, IORING_REGISTER_BUFFERS, iovecs.data(), bufferCount) == 0;
+	unsigned char readOp = fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+	unsigned char writeOp = fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+
+	struct BufferState {
+		std::uint64_t chunk = 0;
+		size_t length = 0;
+		size_t done = 0;
+		bool ready = 0;
+		std::uint64_t writeOffset = 0;
+		size_t writeLength = 0;
+	};
+	std::vector<BufferState> buffers(bufferCount);
+	unsigned int inFlight = 0;
+
+	auto bufferAt = [&](unsigned int b) {
+		return storage + b * bufferSize;
+	};
+	auto startRead = [&](unsigned int b) {
+		BufferState& state = buffers[b];
+		this->submit(readOp, inputFd, bufferAt(b) + state.done, state.length - state.done, inputOffset + state.chunk * chunkSize + state.done, fixedBuffers ? (int)b : -1, (std::uint64_t)b << 1);
+		inFlight++;
+	};
+	auto startWrite = [&](unsigned int b) {
+		BufferState& state = buffers[b];
+		this->submit(writeOp, outputFd, bufferAt(b) + state.done, state.writeLength - state.done, state.writeOffset + state.done, fixedBuffers ? (int)b : -1, ((std::uint64_t)b << 1) | 1);
+		inFlight++;
+	};
+	std::uint64_t nextRead = 0;
+	auto readNextChunk = [&](unsigned int b) {
+		BufferState& state = buffers[b];
+		state.chunk = nextRead;
+		state.length = std::min<std::uint64_t>(chunkSize, inputLength - nextRead * chunkSize);
+		state.done = 0;
+		state.ready = 0;
+		nextRead++;
+		startRead(b);
+	};
+
+	try {
+		for (unsigned int b = 0; b < bufferCount; b++) {
+			readNextChunk(b);
+		}
+
+		std::uint64_t nextTransform = 0;
+		std::uint64_t chunksWritten = 0;
+		std::uint64_t outputPosition = outputOffset;
+		while (chunksWritten < chunkCount) {
+			//Transform every chunk that is next in order and already read
+			bool transformed = 0;
+			unsigned int b = 0;
+			while (b < bufferCount && nextTransform < chunkCount) {
+				BufferState& state = buffers[b];
+				if (!state.ready || state.chunk != nextTransform) {
+					b++;
+					continue;
+				}
+				state.ready = 0;
+				state.writeLength = transform(bufferAt(b), state.length, nextTransform == chunkCount - 1);
+				state.writeOffset = outputPosition;
+				state.done = 0;
+				outputPosition += state.writeLength;
+				nextTransform++;
+				transformed = 1;
+				if (state.writeLength > 0) {
+					startWrite(b);
+				}
+				else {
+					chunksWritten++;
+					if (nextRead < chunkCount) {
+						readNextChunk(b);
+					}
+				}
+				b = 0;
+			}
+			if (transformed || chunksWritten == chunkCount) {
+				continue;
+			}
+
+			std::uint64_t userData;
+			int result;
+			this->waitCompletion(userData, result);
+			inFlight--;
+			b = userData >> 1;
+			bool isWrite = userData & 1;
+			BufferState& state = buffers[b];
+			if (result <= 0) {
+				throw ANGELITA128_Exception(isWrite ? "ANGELITA128: Could not write output." : "ANGELITA128: Could not read input.");
+			}
+			state.done += result;
+			if (!isWrite) {
+				if (state.done < state.length) {
+					startRead(b);
+				}
+				else {
+					state.ready = 1;
+				}
+			}
+			else {
+				if (state.done < state.writeLength) {
+					startWrite(b);
+				}
+				else {
+					chunksWritten++;
+					if (nextRead < chunkCount) {
+						readNextChunk(b);
+					}
+				}
+			}
+		}
+	}
+	catch (...) {
+		//The kernel still owns the buffers of anything in flight
+		while (inFlight > 0) {
+			std::uint64_t userData;
+			int result;
+			try {
+				this->waitCompletion(userData, result);
+			}
+			catch (ANGELITA128_Exception& err) {
+				break;
+			}
+			inFlight--;
+		}
+		if (fixedBuffers) {
+			syscall(__NR_io_uring_register, this->ringFd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+		}
+		throw;
+	}
+
+	if (fixedBuffers) {
+		syscall(__NR_io_uring_register, this->ringFd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+	}
+}
+
+#endif
@@ -0,0 +1,131 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 file I/O backend header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 I/O backend classes
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+#ifndef ANGELITA128_IO_H
+#define ANGELITA128_IO_H
+
+#include "ANGELITA128_Exception.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+//Called once per chunk in file order, works on the buffer in place
+//The buffer has 16 spare bytes past the chunk for padding, returns the output length
+//The last call has lastChunk set, and may have length 0 for an empty input
+typedef std::function<size_t(unsigned char* buffer, size_t length, bool lastChunk)> ANGELITA128_ChunkTransform;
+
+class ANGELITA128_IO {
+public:
+	virtual ~ANGELITA128_IO() {}
+
+	//Read inputFd from inputOffset to the end in chunks, transform each and write them to outputFd from outputOffset
+	virtual void run(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, size_t chunkSize, ANGELITA128_ChunkTransform transform) = 0;
+	virtual std::string name() const = 0;
+
+	//"blocking", "pipeline", "io_uring", or "auto" for io_uring where the kernel allows it and the pipeline otherwise
+	static std::unique_ptr<ANGELITA128_IO> create(std::string backend);
+
+	//Positioned whole reads and writes, retried until done
+	static void readAt(int fd, unsigned char* buffer, size_t length, std::uint64_t offset);
+	static void writeAt(int fd, const unsigned char* buffer, size_t length, std::uint64_t offset);
+
+	//Whole reads and writes at the current position, for pipes; readAll returns less only at the end of the input
+	static size_t readAll(int fd, unsigned char* buffer, size_t length);
+	static void writeAll(int fd, const unsigned char* buffer, size_t length);
+};
+
+class ANGELITA128_BlockingIO : public ANGELITA128_IO {
+public:
+	void run(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, size_t chunkSize, ANGELITA128_ChunkTransform transform) override;
+	std::string name() const override { return "blocking"; }
+};
+
+class ANGELITA128_PipelineIO : public ANGELITA128_IO {
+private:
+	unsigned int ringSize;
+
+public:
+	//Reader thread, cipher (calling) thread and writer thread, passing a ring of ringSize reused buffers
+	ANGELITA128_PipelineIO(unsigned int ringSize = 4);
+	void run(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, size_t chunkSize, ANGELITA128_ChunkTransform transform) override;
+	std::string name() const override { return "pipeline"; }
+};
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ANGELITA128_IO_URING 1
+
+class ANGELITA128_UringIO : public ANGELITA128_IO {
+private:
+	int ringFd = -1;
+	unsigned int queueDepth;
+	void* sqRing = nullptr;
+	void* cqRing = nullptr;
+	void* sqes = nullptr;
+	size_t sqRingSize = 0;
+	size_t cqRingSize = 0;
+	size_t sqesSize = 0;
+	unsigned int* sqHead;
+	unsigned int* sqTail;
+	unsigned int* sqMask;
+	unsigned int* sqArray;
+	unsigned int* cqHead;
+	unsigned int* cqTail;
+	unsigned int* cqMask;
+	void* cqes;
+
+	unsigned int pendingSubmits = 0;
+
+	//ANGELITA128_AsyncIO keeps its own requests in a ring, through submit and waitCompletion
+	friend class ANGELITA128_AsyncIO;
+
+	void closeRing();
+	void submit(unsigned char opcode, int fd, unsigned char* buffer, unsigned int length, std::uint64_t offset, int bufferIndex, std::uint64_t userData);
+	void waitCompletion(std::uint64_t& userData, int& result);
+
+public:
+	//Throws if io_uring is not available, so create("auto") can fall back
+	ANGELITA128_UringIO(unsigned int queueDepth = 8);
+	~ANGELITA128_UringIO();
+	ANGELITA128_UringIO(const ANGELITA128_UringIO&) = delete;
+	ANGELITA128_UringIO& operator=(const ANGELITA128_UringIO&) = delete;
+
+	void run(int inputFd, std::uint64_t inputOffset, int outputFd, std::uint64_t outputOffset, size_t chunkSize, ANGELITA128_ChunkTransform transform) override;
+	std::string name() const override { return "io_uring"; }
+};
+
+#endif
+
+#endif
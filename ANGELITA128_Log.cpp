@@ -0,0 +1,378 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 encrypted log methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 encrypted log methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_Log.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/random.h>
+
+static const char LOG_MAGIC[8] = { 'A', 'N', 'G', 'E', 'L', 'L', 'O', 'G' };
+
+//The reader reads the log on this many bytes at a time
+static const size_t READ_BUFFER = 1048576;
+
+static void putU32(unsigned char* bytes, std::uint32_t value) {
+	for (unsigned int i = 0; i < 4; i++) {
+		bytes[i] = (value >> (8 * i)) & 255;
+	}
+}
+
+static std::uint32_t getU32(const unsigned char* bytes) {
+	std::uint32_t value = 0;
+	for (unsigned int i = 0; i < 4; i++) {
+		value |= (std::uint32_t)bytes[i] << (8 * i);
+	}
+	return value;
+}
+
+static std::array<unsigned char, 16> recordNonce(const ANGELITA128& cipher, std::array<unsigned char, 16> IV, const unsigned char* salt, std::uint64_t offset) {
+	//The nonce of the record at offset written with salt
+	for (unsigned int i = 0; i < 8; i++) {
+		IV[i] ^= salt[i];
+	}
+	return cipher.chunkIV(IV, offset);
+}
+
+std::array<unsigned char, 16> ANGELITA128_Log::readHeader(int fd) {
+	//Read and check the log header, returns the log's IV
+	unsigned char bytes[HEADER_SIZE];
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size < HEADER_SIZE) {
+		throw ANGELITA128_Exception("ANGELITA128: File is not an ANGELITA128 log.");
+	}
+	ANGELITA128_IO::readAt(fd, bytes, HEADER_SIZE, 0);
+	if (std::memcmp(bytes, LOG_MAGIC, 8) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: File is not an ANGELITA128 log.");
+	}
+	if (bytes[8] != 2) {
+		throw ANGELITA128_Exception("ANGELITA128: Log version is not supported.");
+	}
+	std::array<unsigned char, 16> IV;
+	std::memcpy(IV.data(), bytes + 16, 16);
+	return IV;
+}
+
+void ANGELITA128_Log::writeHeader(int fd, const std::array<unsigned char, 16>& IV) {
+	unsigned char bytes[HEADER_SIZE] = {};
+	std::memcpy(bytes, LOG_MAGIC, 8);
+	bytes[8] = 2;
+	std::memcpy(bytes + 16, IV.data(), 16);
+	ANGELITA128_IO::writeAt(fd, bytes, HEADER_SIZE, 0);
+}
+
+
+///////////////////
+//Log writer
+///////////////////
+
+ANGELITA128_LogWriter::ANGELITA128_LogWriter(ANGELITA128& cipher, std::string file, bool syncGroups, size_t maxGroupBytes)
+	: cipher(cipher), syncGroups(syncGroups), maxGroupBytes(maxGroupBytes) {
+	//Open or create the log and start the commit thread
+	if (!cipher.hasKey()) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to encrypt.");
+	}
+	this->fd = open(file.c_str(), O_RDWR | O_CREAT, 0666);
+	if (this->fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open log for write.");
+	}
+	try {
+		if (flock(this->fd, LOCK_EX | LOCK_NB) != 0) {
+			throw ANGELITA128_Exception("ANGELITA128: Log is already open in another writer.");
+		}
+		//GLORIA runs on rand(), which two writers started in the same second could share, so the salt comes from the kernel
+		if (getrandom(this->salt.data(), this->salt.size(), 0) != (ssize_t)this->salt.size()) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not get a random salt for the log.");
+		}
+		struct stat fileStat;
+		fstat(this->fd, &fileStat);
+		if (fileStat.st_size == 0) {
+			this->IV = cipher.newIV();
+			ANGELITA128_Log::writeHeader(this->fd, this->IV);
+			if (fdatasync(this->fd) != 0) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not sync log.");
+			}
+			this->endOffset = ANGELITA128_Log::HEADER_SIZE;
+		}
+		else {
+			this->IV = ANGELITA128_Log::readHeader(this->fd);
+
+			//Walk the records by their lengths to the last one that is all there
+			std::vector<std::pair<std::uint64_t, std::uint32_t>> records;
+			std::uint64_t end = ANGELITA128_Log::HEADER_SIZE;
+			unsigned char lengthBytes[4];
+			while (end + ANGELITA128_Log::RECORD_HEADER <= (std::uint64_t)fileStat.st_size) {
+				ANGELITA128_IO::readAt(this->fd, lengthBytes, 4, end);
+				std::uint32_t length = getU32(lengthBytes);
+				if (length > ANGELITA128_Log::MAX_RECORD || end + ANGELITA128_Log::RECORD_HEADER + length > (std::uint64_t)fileStat.st_size) {
+					break;
+				}
+				records.push_back({ end, length });
+				end += ANGELITA128_Log::RECORD_HEADER + length;
+			}
+
+			//The last group may have reached the disk only in part before a crash, so records at the end that fail their tags go
+			//A first record that fails is a wrong key rather than a crash, and nothing is cut off for it
+			if (!records.empty() && !this->recordIntact(records.front().first, records.front().second)) {
+				throw ANGELITA128_Exception("ANGELITA128: Log did not decrypt, wrong key or damaged log.");
+			}
+			while (!records.empty() && !this->recordIntact(records.back().first, records.back().second)) {
+				end = records.back().first;
+				records.pop_back();
+			}
+			if (end < (std::uint64_t)fileStat.st_size && ftruncate(this->fd, end) != 0) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not cut off the torn end of the log.");
+			}
+			this->endOffset = end;
+		}
+		this->committedOffset = this->endOffset;
+		this->committer = std::thread(&ANGELITA128_LogWriter::commitGroups, this);
+	}
+	catch (...) {
+		close(this->fd);
+		throw;
+	}
+}
+
+ANGELITA128_LogWriter::~ANGELITA128_LogWriter() {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->stopping = 1;
+	}
+	this->recordsReady.notify_one();
+	this->committer.join();
+	close(this->fd);
+}
+
+bool ANGELITA128_LogWriter::recordIntact(std::uint64_t offset, std::uint32_t length) const {
+	//Check one record's tag, used when an existing log is opened
+	std::vector<unsigned char> stored(ANGELITA128_Log::RECORD_HEADER + length);
+	std::vector<unsigned char> plaintext(length);
+	ANGELITA128_IO::readAt(this->fd, stored.data(), stored.size(), offset);
+	std::array<unsigned char, 16> tag;
+	std::memcpy(tag.data(), stored.data() + 12, 16);
+	try {
+		this->cipher.decryptAuthenticated(std::span<const std::uint8_t>(stored).subspan(ANGELITA128_Log::RECORD_HEADER), plaintext,
+			recordNonce(this->cipher, this->IV, stored.data() + 4, offset), tag);
+	}
+	catch (ANGELITA128_Exception& e) {
+		return 0;
+	}
+	return 1;
+}
+
+void ANGELITA128_LogWriter::commitGroups() {
+	//Write the records that follow on from the committed ones out as one group with one write, then sync it
+	//Records appended while a group is being written and synced make up the next one, so the busier the log the bigger the groups
+	std::unique_lock<std::mutex> guard(this->lock);
+	while (1) {
+		this->recordsReady.wait(guard, [&]() {
+			return this->stopping || (!this->ready.empty() && this->ready.begin()->first == this->committedOffset);
+		});
+		if (this->ready.empty() || this->ready.begin()->first != this->committedOffset) {
+			return;
+		}
+		std::vector<unsigned char> group;
+		std::uint64_t groupStart = this->committedOffset;
+		auto next = this->ready.begin();
+		while (next != this->ready.end() && next->first == groupStart + group.size() &&
+			(group.empty() || group.size() + next->second.size() <= this->maxGroupBytes)) {
+			group.insert(group.end(), next->second.begin(), next->second.end());
+			next = this->ready.erase(next);
+		}
+		guard.unlock();
+		try {
+			ANGELITA128_IO::writeAt(this->fd, group.data(), group.size(), groupStart);
+			if (this->syncGroups && fdatasync(this->fd) != 0) {
+				throw ANGELITA128_Exception("ANGELITA128: Could not sync log.");
+			}
+		}
+		catch (...) {
+			guard.lock();
+			this->failure = std::current_exception();
+			this->groupCommitted.notify_all();
+			return;
+		}
+		guard.lock();
+		this->committedOffset = groupStart + group.size();
+		this->logStats.groups++;
+		this->logStats.syncs += this->syncGroups;
+		this->groupCommitted.notify_all();
+	}
+}
+
+std::uint64_t ANGELITA128_LogWriter::append(std::span<const std::uint8_t> record, bool waitForCommit) {
+	//Take the next offset, encrypt the record in this thread and hand it to the commit thread
+	if (record.size() > ANGELITA128_Log::MAX_RECORD) {
+		throw ANGELITA128_Exception("ANGELITA128: Log record is too long, the most is 1 GiB.");
+	}
+	std::vector<unsigned char> stored(ANGELITA128_Log::RECORD_HEADER + record.size());
+	std::uint64_t offset;
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		if (this->failure) {
+			std::rethrow_exception(this->failure);
+		}
+		offset = this->endOffset;
+		this->endOffset += stored.size();
+	}
+	putU32(stored.data(), record.size());
+	std::memcpy(stored.data() + 4, this->salt.data(), 8);
+	std::array<unsigned char, 16> tag;
+	this->cipher.encryptAuthenticated(record, std::span<std::uint8_t>(stored).subspan(ANGELITA128_Log::RECORD_HEADER),
+		recordNonce(this->cipher, this->IV, this->salt.data(), offset), tag);
+	std::memcpy(stored.data() + 12, tag.data(), 16);
+
+	std::unique_lock<std::mutex> guard(this->lock);
+	this->ready.emplace(offset, std::move(stored));
+	this->logStats.records++;
+	this->logStats.bytes += record.size();
+	this->recordsReady.notify_one();
+	if (waitForCommit) {
+		this->groupCommitted.wait(guard, [&]() { return this->failure || this->committedOffset > offset; });
+		if (this->committedOffset <= offset) {
+			std::rethrow_exception(this->failure);
+		}
+	}
+	return offset;
+}
+
+void ANGELITA128_LogWriter::flush() {
+	//Wait until every record appended so far is committed
+	std::unique_lock<std::mutex> guard(this->lock);
+	std::uint64_t target = this->endOffset;
+	this->groupCommitted.wait(guard, [&]() { return this->failure || this->committedOffset >= target; });
+	if (this->committedOffset < target) {
+		std::rethrow_exception(this->failure);
+	}
+}
+
+ANGELITA128_LogStats ANGELITA128_LogWriter::stats() {
+	std::lock_guard<std::mutex> guard(this->lock);
+	return this->logStats;
+}
+
+void ANGELITA128_LogWriter::showStats() {
+	//Output the commit figures to the console
+	ANGELITA128_LogStats logStats = this->stats();
+	std::cout << "Log records: " << logStats.records << ", bytes: " << logStats.bytes << ", groups: " << logStats.groups;
+	if (logStats.groups > 0) {
+		std::cout << " (" << (double)logStats.records / logStats.groups << " records per group)";
+	}
+	std::cout << ", syncs: " << logStats.syncs << "\n";
+}
+
+
+///////////////////
+//Log reader
+///////////////////
+
+ANGELITA128_LogReader::ANGELITA128_LogReader(const ANGELITA128& cipher, std::string file, std::uint64_t checkpoint)
+	: cipher(cipher), offset(checkpoint) {
+	//Open a log to read its records in order
+	if (!cipher.hasKey()) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to decrypt.");
+	}
+	this->fd = open(file.c_str(), O_RDONLY);
+	if (this->fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open log for read.");
+	}
+	try {
+		this->IV = ANGELITA128_Log::readHeader(this->fd);
+	}
+	catch (...) {
+		close(this->fd);
+		throw;
+	}
+	if (this->offset < ANGELITA128_Log::HEADER_SIZE) {
+		this->offset = ANGELITA128_Log::HEADER_SIZE;
+	}
+}
+
+ANGELITA128_LogReader::~ANGELITA128_LogReader() {
+	close(this->fd);
+}
+
+const unsigned char* ANGELITA128_LogReader::fill(std::uint64_t start, size_t length) {
+	//Point at length bytes of the log from start, reading on a large piece at a time; null if the log doesn't have them yet
+	if (start >= this->bufferStart && start + length <= this->bufferStart + this->bufferLength) {
+		return this->buffer.data() + (start - this->bufferStart);
+	}
+	struct stat fileStat;
+	fstat(this->fd, &fileStat);
+	if (start + length > (std::uint64_t)fileStat.st_size) {
+		return nullptr;
+	}
+	size_t readLength = std::min<std::uint64_t>(std::max(length, READ_BUFFER), fileStat.st_size - start);
+	if (this->buffer.size() < readLength) {
+		this->buffer.resize(readLength);
+	}
+	ANGELITA128_IO::readAt(this->fd, this->buffer.data(), readLength, start);
+	this->bufferStart = start;
+	this->bufferLength = readLength;
+	return this->buffer.data();
+}
+
+bool ANGELITA128_LogReader::next(std::vector<unsigned char>& record) {
+	//Decrypt the record at the checkpoint and move the checkpoint past it
+	const unsigned char* recordHeader = this->fill(this->offset, ANGELITA128_Log::RECORD_HEADER);
+	if (recordHeader == nullptr) {
+		return 0;
+	}
+	std::uint32_t length = getU32(recordHeader);
+	std::array<unsigned char, 16> tag;
+	std::memcpy(tag.data(), recordHeader + 12, 16);
+	std::array<unsigned char, 16> nonce = recordNonce(this->cipher, this->IV, recordHeader + 4, this->offset);
+	if (length > ANGELITA128_Log::MAX_RECORD) {
+		throw ANGELITA128_Exception("ANGELITA128: Log record is damaged.");
+	}
+	const unsigned char* ciphertext = this->fill(this->offset + ANGELITA128_Log::RECORD_HEADER, length);
+	if (ciphertext == nullptr) {
+		return 0;
+	}
+	record.resize(length);
+	this->cipher.decryptAuthenticated(std::span<const std::uint8_t>(ciphertext, length), record, nonce, tag);
+	this->offset += ANGELITA128_Log::RECORD_HEADER + length;
+	return 1;
+}
+
+std::uint64_t ANGELITA128_LogReader::checkpoint() const {
+	return this->offset;
+}
@@ -0,0 +1,148 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 encrypted log header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 encrypted log classes
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+/*
+	Encrypted log layout, all numbers little endian:
+
+	Header (32 bytes):
+		magic "ANGELLOG", version 2, reserved (7), IV (16)
+	Records, one after the other:
+		length (4), salt (8), tag (16), the record encrypted with encryptAuthenticated (length)
+
+	A record's nonce is chunkIV(IV with the salt XORed into its first 8 bytes, offset of the record in the file), so any
+	record can be decrypted on its own given where it starts; that offset is the checkpoint to read on from.
+	The salt is drawn at random each time a writer opens the log. Opening after a crash cuts off a torn record and
+	appends again at its offset, and the torn ciphertext may already be in a backup, so the offset alone would
+	encrypt new records with its keystream; with a new salt they get a nonce of their own.
+*/
+
+#ifndef ANGELITA128_LOG_H
+#define ANGELITA128_LOG_H
+
+#include "ANGELITA128.h"
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+
+struct ANGELITA128_LogStats {
+	std::uint64_t records = 0;
+	std::uint64_t bytes = 0;
+	std::uint64_t groups = 0;
+	std::uint64_t syncs = 0;
+};
+
+class ANGELITA128_Log {
+public:
+	static const unsigned int HEADER_SIZE = 32;
+	static const unsigned int RECORD_HEADER = 28;
+	static const std::uint32_t MAX_RECORD = 1073741824;
+
+	static std::array<unsigned char, 16> readHeader(int fd);
+	static void writeHeader(int fd, const std::array<unsigned char, 16>& IV);
+};
+
+class ANGELITA128_LogWriter {
+private:
+	const ANGELITA128& cipher;
+	int fd = -1;
+	std::array<unsigned char, 16> IV = {};
+	std::array<unsigned char, 8> salt = {};
+	bool syncGroups;
+	size_t maxGroupBytes;
+
+	//Records get their offsets in append order, are encrypted by the producers side by side,
+	//then wait in ready until the commit thread writes them out in order
+	std::mutex lock;
+	std::condition_variable recordsReady;
+	std::condition_variable groupCommitted;
+	std::uint64_t endOffset = 0;
+	std::uint64_t committedOffset = 0;
+	std::map<std::uint64_t, std::vector<unsigned char>> ready;
+	bool stopping = 0;
+	std::exception_ptr failure;
+	ANGELITA128_LogStats logStats;
+	std::thread committer;
+
+	void commitGroups();
+	bool recordIntact(std::uint64_t offset, std::uint32_t length) const;
+
+public:
+	//Opens the log, or makes a new one with a fresh IV, so the cipher is not const; it must outlive the writer
+	//An existing log carries on after its last whole record, anything torn after it by a crash is cut off
+	//syncGroups makes each group durable with fdatasync before its appends return
+	ANGELITA128_LogWriter(ANGELITA128& cipher, std::string file, bool syncGroups = 1, size_t maxGroupBytes = 4194304);
+	//Commits everything appended so far
+	~ANGELITA128_LogWriter();
+	ANGELITA128_LogWriter(const ANGELITA128_LogWriter&) = delete;
+	ANGELITA128_LogWriter& operator=(const ANGELITA128_LogWriter&) = delete;
+
+	//Safe to call from many threads, returns the record's offset
+	//waitForCommit waits until the group holding the record is written (and synced), otherwise flush() does
+	std::uint64_t append(std::span<const std::uint8_t> record, bool waitForCommit = 1);
+	void flush();
+	ANGELITA128_LogStats stats();
+	void showStats();
+};
+
+class ANGELITA128_LogReader {
+private:
+	const ANGELITA128& cipher;
+	int fd = -1;
+	std::array<unsigned char, 16> IV = {};
+	std::uint64_t offset;
+
+	//Records are read out of large sequential reads of the file
+	std::vector<unsigned char> buffer;
+	std::uint64_t bufferStart = 0;
+	size_t bufferLength = 0;
+
+	const unsigned char* fill(std::uint64_t start, size_t length);
+
+public:
+	//Reads from checkpoint, the offset of a record as append() or checkpoint() gave it, or from the first record
+	//The cipher must be keyed, and outlive the reader
+	ANGELITA128_LogReader(const ANGELITA128& cipher, std::string file, std::uint64_t checkpoint = 0);
+	~ANGELITA128_LogReader();
+	ANGELITA128_LogReader(const ANGELITA128_LogReader&) = delete;
+	ANGELITA128_LogReader& operator=(const ANGELITA128_LogReader&) = delete;
+
+	//Decrypts the next record into record, false at the end of what has been written so far (so it can be called again later)
+	//A record that fails its tag throws
+	bool next(std::vector<unsigned char>& record);
+	std::uint64_t checkpoint() const;
+};
+
+#endif
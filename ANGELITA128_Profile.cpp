@@ -0,0 +1,324 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 calibration methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 calibration and tuning profile methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include "ANGELITA128_Scheduler.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+
+//Any key does, the timings don't depend on it
+static const char* CALIBRATION_KEY = "e5077dce18a81e4e80a6df19b64dcf25";
+//Lane counts are timed on one thread over a buffer that stays in cache
+static const size_t LANE_BYTES = 262144;
+//Thread counts are timed over pieces the size of a small file, a few per thread
+static const size_t PIECE_BYTES = 65536;
+static const size_t PIECES_PER_CORE = 8;
+//Chunk sizes are timed over a whole stream, several times the largest chunk
+static const size_t STREAM_BYTES = 16777216;
+static const size_t CHUNK_SIZES[] = {65536, 262144, 1048576, 4194304};
+//A smaller thread count within this much of the fastest is taken
+static const double THREAD_MARGIN = 0.95;
+
+static std::mutex profileLock;
+static ANGELITA128_Profile activeProfile;
+static bool environmentChecked = 0;
+
+static unsigned int hostCores() {
+	//The core count the scheduler sizes itself on
+	return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+static double measureSpeed(size_t bytes, unsigned int runs, const std::function<void()>& work) {
+	//Run work runs times and return the fastest in MB/s
+	double bestSeconds = 0;
+	for (unsigned int run = 0; run < runs; run++) {
+		auto start = std::chrono::steady_clock::now();
+		work();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (run == 0 || seconds < bestSeconds) {
+			bestSeconds = seconds;
+		}
+	}
+	return bestSeconds > 0 ? bytes / bestSeconds / 1000000.0 : 0;
+}
+
+static bool readProfile(std::string profileFile, ANGELITA128_Profile& profile) {
+	//Read a saved profile, false if it is missing, damaged or for another machine
+	std::ifstream input(profileFile);
+	std::string line;
+	if (!std::getline(input, line) || line != "ANGELITA128 profile 1") {
+		return 0;
+	}
+	ANGELITA128_Profile saved;
+	saved.calibrated = 1;
+	while (std::getline(input, line)) {
+		std::istringstream fields(line);
+		std::string name;
+		unsigned long long value;
+		if (!(fields >> name >> value)) {
+			return 0;
+		}
+		if (name == "cores") {
+			saved.cores = value;
+		}
+		else if (name == "lanes") {
+			saved.laneCount = value;
+		}
+		else if (name == "chunk") {
+			saved.chunkSize = value;
+		}
+		else if (name == "threads") {
+			saved.threadCount = value;
+		}
+	}
+	if (saved.cores != hostCores() || saved.laneCount < 1 || saved.laneCount > 16 || saved.chunkSize < 16 || saved.chunkSize % 16 != 0 || saved.threadCount > saved.cores) {
+		return 0;
+	}
+	profile = saved;
+	return 1;
+}
+
+static void saveProfile(const ANGELITA128_Profile& profile, std::string profileFile) {
+	//Write the profile next to its final name and move it into place, so a reader never sees half of one
+	std::string tempFile = profileFile + ".tmp";
+	{
+		std::ofstream output(tempFile, std::ios::trunc);
+		output << "ANGELITA128 profile 1\n";
+		output << "cores " << profile.cores << "\n";
+		output << "lanes " << profile.laneCount << "\n";
+		output << "chunk " << profile.chunkSize << "\n";
+		output << "threads " << profile.threadCount << "\n";
+		output.flush();
+		if (!output) {
+			std::remove(tempFile.c_str());
+			throw ANGELITA128_Exception("ANGELITA128: Could not save the tuning profile.");
+		}
+	}
+	if (std::rename(tempFile.c_str(), profileFile.c_str()) != 0) {
+		std::remove(tempFile.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not save the tuning profile.");
+	}
+}
+
+
+///////////////////
+//Profile
+///////////////////
+
+void ANGELITA128_Profile::showProfile() const {
+	//Output the settings in use and, when just calibrated, how fast each was
+	std::ios oldState(nullptr);
+	oldState.copyfmt(std::cout);
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "Profile: " << (this->calibrated ? "calibrated" : "defaults") << ", cores: " << this->cores << "\n";
+	std::cout << "Lanes: " << this->laneCount;
+	if (this->laneSpeed > 0) {
+		std::cout << " (" << this->laneSpeed << " MB/s)";
+	}
+	std::cout << "\nChunk size: " << this->chunkSize;
+	if (this->chunkSpeed > 0) {
+		std::cout << " (" << this->chunkSpeed << " MB/s)";
+	}
+	std::cout << "\nThreads: ";
+	if (this->threadCount == 0) {
+		std::cout << "one per core";
+	}
+	else {
+		std::cout << this->threadCount;
+	}
+	if (this->threadSpeed > 0) {
+		std::cout << " (" << this->threadSpeed << " MB/s)";
+	}
+	std::cout << "\n";
+	std::cout.copyfmt(oldState);
+}
+
+
+///////////////////
+//Calibration
+///////////////////
+
+ANGELITA128_Profile ANGELITA128::calibrate(std::string profileFile) {
+	//Time the candidates on this machine, use the fastest of each from now on and save them to profileFile unless it is empty
+	//Lane counts first, then thread counts with the winning lanes, then chunk sizes through the I/O backend
+	ANGELITA128_Profile profile;
+	profile.calibrated = 1;
+	profile.cores = hostCores();
+	ANGELITA128 cipher;
+	cipher.setKeyH(CALIBRATION_KEY);
+
+	//Lane count, the width of the lane kernel every parallel mode runs on
+	std::vector<unsigned char> laneData(LANE_BYTES);
+	for (size_t i = 0; i < laneData.size(); i++) {
+		laneData[i] = i * 131;
+	}
+	for (unsigned int lanes = 1; lanes <= 16; lanes *= 2) {
+		cipher.setLaneCount(lanes);
+		double speed = measureSpeed(LANE_BYTES, 3, [&]() {
+			cipher.encryptECB(laneData.data(), laneData.data(), LANE_BYTES / 16);
+		});
+		if (speed > profile.laneSpeed) {
+			profile.laneSpeed = speed;
+			profile.laneCount = lanes;
+		}
+	}
+	cipher.setLaneCount(profile.laneCount);
+
+	//Thread count, 1, 2, 4... up to one per core on the shared scheduler, the way a batch spreads its files
+	std::vector<unsigned char> threadData(PIECE_BYTES * PIECES_PER_CORE * profile.cores);
+	size_t pieces = threadData.size() / PIECE_BYTES;
+	std::vector<unsigned int> threadCounts;
+	for (unsigned int threads = 1; threads < profile.cores; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(profile.cores);
+	std::vector<double> threadSpeeds;
+	for (unsigned int threads : threadCounts) {
+		threadSpeeds.push_back(measureSpeed(threadData.size(), 2, [&]() {
+			ANGELITA128_Scheduler::shared().forEach(pieces, threads, [&](size_t piece) {
+				unsigned char* data = threadData.data() + piece * PIECE_BYTES;
+				cipher.encryptECB(data, data, PIECE_BYTES / 16);
+			});
+		}));
+	}
+	double fastest = *std::max_element(threadSpeeds.begin(), threadSpeeds.end());
+	for (unsigned int t = 0; t < threadCounts.size(); t++) {
+		if (threadSpeeds[t] >= fastest * THREAD_MARGIN) {
+			profile.threadCount = threadCounts[t];
+			profile.threadSpeed = threadSpeeds[t];
+			break;
+		}
+	}
+
+	//Chunk size, a stream from a temporary file to /dev/null so the reads, writes and cache footprint all count
+	FILE* inputFile = std::tmpfile();
+	int outputFd = open("/dev/null", O_WRONLY);
+	if (!inputFile || outputFd < 0) {
+		if (inputFile) {
+			std::fclose(inputFile);
+		}
+		if (outputFd >= 0) {
+			close(outputFd);
+		}
+		throw ANGELITA128_Exception("ANGELITA128: Could not open files to calibrate.");
+	}
+	int inputFd = fileno(inputFile);
+	try {
+		for (size_t written = 0; written < STREAM_BYTES; written += LANE_BYTES) {
+			ANGELITA128_IO::writeAll(inputFd, laneData.data(), LANE_BYTES);
+		}
+		for (size_t chunkSize : CHUNK_SIZES) {
+			cipher.setChunkSize(chunkSize);
+			double speed = measureSpeed(STREAM_BYTES, 1, [&]() {
+				lseek(inputFd, 0, SEEK_SET);
+				cipher.encryptStream(inputFd, outputFd, "ecb");
+			});
+			if (speed > profile.chunkSpeed) {
+				profile.chunkSpeed = speed;
+				profile.chunkSize = chunkSize;
+			}
+		}
+	}
+	catch (...) {
+		std::fclose(inputFile);
+		close(outputFd);
+		throw;
+	}
+	std::fclose(inputFile);
+	close(outputFd);
+
+	useProfile(profile);
+	if (!profileFile.empty()) {
+		saveProfile(profile, profileFile);
+	}
+	return profile;
+}
+
+bool ANGELITA128::loadProfile(std::string profileFile) {
+	//Use a profile saved by calibrate(), false (and nothing changed) if it can't be used here
+	ANGELITA128_Profile profile;
+	if (!readProfile(profileFile, profile)) {
+		return 0;
+	}
+	useProfile(profile);
+	return 1;
+}
+
+void ANGELITA128::useProfile(const ANGELITA128_Profile& profile) {
+	//Make profile the one new objects and thread counts of 0 follow
+	if (profile.laneCount < 1 || profile.laneCount > 16) {
+		throw ANGELITA128_Exception("ANGELITA128: Lane count must be from 1 to 16.");
+	}
+	if (profile.chunkSize < 16 || profile.chunkSize % 16 != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Chunk size must be a multiple of 16 bytes.");
+	}
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		activeProfile = profile;
+		environmentChecked = 1;
+	}
+	ANGELITA128_Scheduler::shared().setThreadCount(profile.threadCount);
+}
+
+ANGELITA128_Profile ANGELITA128::profile() {
+	//The profile in use; the first call loads the one ANGELITA128_PROFILE names, if it is set and can be used
+	ANGELITA128_Profile profile;
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		if (environmentChecked) {
+			return activeProfile;
+		}
+		environmentChecked = 1;
+		activeProfile.cores = hostCores();
+		const char* profileFile = std::getenv("ANGELITA128_PROFILE");
+		if (!profileFile || !readProfile(profileFile, profile)) {
+			return activeProfile;
+		}
+		activeProfile = profile;
+	}
+	ANGELITA128_Scheduler::shared().setThreadCount(profile.threadCount);
+	return profile;
+}
@@ -0,0 +1,71 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 tuning profile header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 tuning profile structure
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+/*
+	A tuning profile is the lane count, chunk size and thread count that ANGELITA128::calibrate() measured as
+	fastest on this machine. The profile in use is taken by every ANGELITA128 object when it is made, and its thread
+	count becomes what a thread count of 0 means, so encrypt/decrypt and the batch engine follow it without any
+	other change; setLaneCount, setChunkSize and setThreadCount still override it.
+
+	Saved profiles are text, one setting per line:
+		ANGELITA128 profile 1
+		cores 8
+		lanes 16
+		chunk 1048576
+		threads 8
+	A profile saved on a machine with a different number of cores is not used.
+*/
+
+#ifndef ANGELITA128_PROFILE_H
+#define ANGELITA128_PROFILE_H
+
+#include <string>
+#include <cstddef>
+
+struct ANGELITA128_Profile {
+	//0 for the built-in defaults, which are used until a profile is calibrated or loaded
+	bool calibrated = 0;
+	unsigned int cores = 0;
+	unsigned int laneCount = 16;
+	size_t chunkSize = 1048576;
+	//0 for one per core
+	unsigned int threadCount = 0;
+	//MB/s of each winner when calibrated in this process, 0 when loaded from a file
+	double laneSpeed = 0;
+	double chunkSpeed = 0;
+	double threadSpeed = 0;
+
+	void showProfile() const;
+};
+
+#endif
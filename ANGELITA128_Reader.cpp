@@ -0,0 +1,181 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 random access reader methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 Reader class methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_Reader.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+
+ANGELITA128_Reader::ANGELITA128_Reader(const ANGELITA128& cipher, std::string file, size_t cacheChunks, unsigned int maxReadAhead)
+	: cipher(cipher), cacheChunks(cacheChunks), maxReadAhead(maxReadAhead) {
+	//Open a chunked container for random reads of its plaintext
+	if (this->cacheChunks == 0) {
+		this->cacheChunks = 1;
+	}
+	this->fd = open(file.c_str(), O_RDONLY);
+	if (this->fd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and decrypt.");
+	}
+	try {
+		this->header = ANGELITA128_Container::readHeader(this->fd);
+		this->entries = ANGELITA128_Container::readIndex(this->fd, this->header);
+		this->mode = ANGELITA128_Container::modeName(this->header.mode);
+	}
+	catch (...) {
+		close(this->fd);
+		throw;
+	}
+}
+
+ANGELITA128_Reader::~ANGELITA128_Reader() {
+	close(this->fd);
+}
+
+void ANGELITA128_Reader::loadChunks(std::uint64_t firstChunk, std::uint64_t count) {
+	//Read consecutive chunks with one read, decrypt them and put them in the cache
+	//Consecutive chunks are stored one after the other unless an update moved one
+	std::uint64_t start = this->entries[firstChunk].offset;
+	std::uint64_t end = start;
+	for (std::uint64_t c = firstChunk; c < firstChunk + count; c++) {
+		if (this->entries[c].offset != end) {
+			count = c - firstChunk;
+			break;
+		}
+		end += this->entries[c].storedLength;
+	}
+	if (count == 0) {
+		count = 1;
+		end = start + this->entries[firstChunk].storedLength;
+	}
+	std::vector<unsigned char> stored(end - start);
+	ANGELITA128_IO::readAt(this->fd, stored.data(), stored.size(), start);
+
+	for (std::uint64_t c = firstChunk; c < firstChunk + count; c++) {
+		const ANGELITA128_ChunkEntry& entry = this->entries[c];
+		if (this->cache.count(c)) {
+			continue;
+		}
+		std::vector<unsigned char> plaintext(std::max(entry.storedLength, entry.plainLength));
+		this->cipher.decryptChunk(this->mode, stored.data() + (entry.offset - start), plaintext.data(), entry, this->header.codec);
+		plaintext.resize(entry.plainLength);
+
+		while (this->cache.size() >= this->cacheChunks) {
+			this->cache.erase(this->lruOrder.back());
+			this->lruOrder.pop_back();
+		}
+		this->lruOrder.push_front(c);
+		this->cache.emplace(c, std::make_pair(std::move(plaintext), this->lruOrder.begin()));
+	}
+}
+
+const std::vector<unsigned char>& ANGELITA128_Reader::getChunk(std::uint64_t chunk, unsigned int readAhead) {
+	//Get a decrypted chunk from the cache, or decrypt it along with up to readAhead chunks after it
+	auto found = this->cache.find(chunk);
+	if (found != this->cache.end()) {
+		this->readerStats.hits++;
+		this->lruOrder.splice(this->lruOrder.begin(), this->lruOrder, found->second.second);
+		return found->second.first;
+	}
+	this->readerStats.misses++;
+	std::uint64_t count = 1;
+	while (count <= readAhead && chunk + count < this->entries.size() && !this->cache.count(chunk + count) && count < this->cacheChunks) {
+		count++;
+	}
+	this->readerStats.readAheads += count - 1;
+	this->loadChunks(chunk, count);
+
+	//Read-ahead chunks go in after the one asked for, so move it back to the front
+	found = this->cache.find(chunk);
+	this->lruOrder.splice(this->lruOrder.begin(), this->lruOrder, found->second.second);
+	return found->second.first;
+}
+
+size_t ANGELITA128_Reader::pread(void* buffer, size_t length, std::uint64_t offset) {
+	//Read plaintext bytes like pread(2), returns how many were read, 0 at or past the end
+	//Reads that carry on from where the last one ended turn on read-ahead of the chunks after them
+	std::lock_guard<std::mutex> guard(this->lock);
+	if (offset >= this->header.totalLength) {
+		return 0;
+	}
+	length = std::min<std::uint64_t>(length, this->header.totalLength - offset);
+
+	if (offset == this->lastReadEnd && offset > 0) {
+		this->sequentialReads++;
+	}
+	else {
+		this->sequentialReads = 0;
+	}
+	this->lastReadEnd = offset + length;
+	unsigned int readAhead = std::min(this->sequentialReads, this->maxReadAhead);
+
+	unsigned char* output = (unsigned char*)buffer;
+	size_t done = 0;
+	while (done < length) {
+		std::uint64_t position = offset + done;
+		std::uint64_t chunk = position / this->header.chunkSize;
+		size_t inChunk = position % this->header.chunkSize;
+		const std::vector<unsigned char>& plaintext = this->getChunk(chunk, readAhead);
+		size_t bytes = std::min<size_t>(length - done, plaintext.size() - inChunk);
+		std::memcpy(output + done, plaintext.data() + inChunk, bytes);
+		done += bytes;
+	}
+	return done;
+}
+
+std::uint64_t ANGELITA128_Reader::size() const {
+	//Plaintext length
+	return this->header.totalLength;
+}
+
+ANGELITA128_ReaderStats ANGELITA128_Reader::stats() const {
+	std::lock_guard<std::mutex> guard(this->lock);
+	ANGELITA128_ReaderStats readerStats = this->readerStats;
+	readerStats.cachedChunks = this->cache.size();
+	return readerStats;
+}
+
+void ANGELITA128_Reader::showStats() const {
+	//Output the cache figures to the console
+	ANGELITA128_ReaderStats readerStats = this->stats();
+	std::uint64_t lookups = readerStats.hits + readerStats.misses;
+	std::cout << "Cache hits: " << readerStats.hits << ", misses: " << readerStats.misses;
+	if (lookups > 0) {
+		std::cout << " (" << (100 * readerStats.hits / lookups) << "% hits)";
+	}
+	std::cout << ", read-ahead chunks: " << readerStats.readAheads << ", cached chunks: " << readerStats.cachedChunks << "\n";
+}
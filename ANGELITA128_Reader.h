@@ -0,0 +1,87 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 random access reader header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 Reader class
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+#ifndef ANGELITA128_READER_H
+#define ANGELITA128_READER_H
+
+#include "ANGELITA128.h"
+#include <list>
+#include <unordered_map>
+#include <mutex>
+
+struct ANGELITA128_ReaderStats {
+	std::uint64_t hits = 0;
+	std::uint64_t misses = 0;
+	std::uint64_t readAheads = 0;
+	size_t cachedChunks = 0;
+};
+
+class ANGELITA128_Reader {
+private:
+	const ANGELITA128& cipher;
+	int fd = -1;
+	ANGELITA128_ContainerHeader header;
+	std::vector<ANGELITA128_ChunkEntry> entries;
+	std::string mode;
+
+	//Decrypted chunks, most recently used at the front of lruOrder
+	size_t cacheChunks;
+	std::list<std::uint64_t> lruOrder;
+	std::unordered_map<std::uint64_t, std::pair<std::vector<unsigned char>, std::list<std::uint64_t>::iterator>> cache;
+	ANGELITA128_ReaderStats readerStats;
+
+	//Sequential read detection
+	std::uint64_t lastReadEnd = 0;
+	unsigned int sequentialReads = 0;
+	unsigned int maxReadAhead;
+
+	mutable std::mutex lock;
+
+	const std::vector<unsigned char>& getChunk(std::uint64_t chunk, unsigned int readAhead);
+	void loadChunks(std::uint64_t firstChunk, std::uint64_t count);
+
+public:
+	//The cipher must be keyed, and outlive the reader
+	ANGELITA128_Reader(const ANGELITA128& cipher, std::string file, size_t cacheChunks = 64, unsigned int maxReadAhead = 4);
+	~ANGELITA128_Reader();
+	ANGELITA128_Reader(const ANGELITA128_Reader&) = delete;
+	ANGELITA128_Reader& operator=(const ANGELITA128_Reader&) = delete;
+
+	size_t pread(void* buffer, size_t length, std::uint64_t offset);
+	std::uint64_t size() const;
+	ANGELITA128_ReaderStats stats() const;
+	void showStats() const;
+};
+
+#endif
@@ -0,0 +1,265 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 re-key methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 re-key methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include "ANGELITA128_Checksum.h"
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+//Blocks below this are not worth starting threads for
+static const size_t PARALLEL_BLOCKS = 4096;
+
+void ANGELITA128::decryptBlocks(unsigned char* blocks, size_t blockCount, bool cbc, std::array<unsigned char, 16>& chainBlock, unsigned int threadCount) const {
+	//Decrypt whole blocks in place, split into one piece per thread; both modes decrypt in parallel
+	//In cbc each piece starts from the ciphertext block before it, saved before any piece overwrites it
+	size_t pieces = blockCount < PARALLEL_BLOCKS ? 1 : threadCount;
+	if (pieces > blockCount) {
+		pieces = blockCount;
+	}
+	if (pieces <= 1) {
+		if (cbc) {
+			this->decryptCBC(blocks, blocks, blockCount, chainBlock);
+		}
+		else {
+			this->decryptECB(blocks, blocks, blockCount);
+		}
+		return;
+	}
+	size_t pieceBlocks = (blockCount + pieces - 1) / pieces;
+	std::vector<std::array<unsigned char, 16>> pieceChains(pieces);
+	for (size_t piece = 0; piece < pieces; piece++) {
+		if (piece == 0) {
+			pieceChains[piece] = chainBlock;
+		}
+		else {
+			std::memcpy(pieceChains[piece].data(), blocks + (piece * pieceBlocks - 1) * 16, 16);
+		}
+	}
+	std::memcpy(chainBlock.data(), blocks + (blockCount - 1) * 16, 16);
+	parallelFor(pieces, pieces, [&](size_t piece) {
+		size_t first = piece * pieceBlocks;
+		size_t count = blockCount - first < pieceBlocks ? blockCount - first : pieceBlocks;
+		if (cbc) {
+			this->decryptCBC(blocks + first * 16, blocks + first * 16, count, pieceChains[piece]);
+		}
+		else {
+			this->decryptECB(blocks + first * 16, blocks + first * 16, count);
+		}
+	});
+}
+
+void ANGELITA128::encryptBlocks(unsigned char* blocks, size_t blockCount, bool cbc, std::array<unsigned char, 16>& chainBlock, unsigned int threadCount) const {
+	//Encrypt whole blocks in place, ecb split into one piece per thread, cbc has to run in order
+	size_t pieces = cbc || blockCount < PARALLEL_BLOCKS ? 1 : threadCount;
+	if (pieces <= 1) {
+		if (cbc) {
+			this->encryptCBC(blocks, blocks, blockCount, chainBlock);
+		}
+		else {
+			this->encryptECB(blocks, blocks, blockCount);
+		}
+		return;
+	}
+	size_t pieceBlocks = (blockCount + pieces - 1) / pieces;
+	parallelFor(pieces, pieces, [&](size_t piece) {
+		size_t first = piece * pieceBlocks;
+		if (first < blockCount) {
+			size_t count = blockCount - first < pieceBlocks ? blockCount - first : pieceBlocks;
+			this->encryptECB(blocks + first * 16, blocks + first * 16, count);
+		}
+	});
+}
+
+void ANGELITA128::rekey(std::string file, std::string mode, ANGELITA128& newCipher, unsigned int threadCount) const {
+	//Re-key an "ecb" or "cbc" file made by encrypt(), through the I/O backend one chunk at a time
+	//The padding block is decrypted and encrypted again like any other, it is only checked to catch a wrong old key
+	if (!this->keySet || !newCipher.keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Old and new keys must be set to re-key.");
+	}
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid re-key mode, must be \"ecb\" or \"cbc\".");
+	}
+	threadCount = resolveThreadCount(threadCount);
+	bool cbc = mode == "cbc";
+
+	int inputFd = open(file.c_str(), O_RDONLY);
+	if (inputFd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and re-key.");
+	}
+	struct stat inputStat;
+	fstat(inputFd, &inputStat);
+	if (inputStat.st_size == 0 || inputStat.st_size % 16 != 0 || (cbc && inputStat.st_size < 32)) {
+		close(inputFd);
+		throw ANGELITA128_Exception("ANGELITA128: File size is not valid for re-key, file is not encrypted in this mode.");
+	}
+	std::string outputName = file + ".ANGELITA128_rekey";
+	int outputFd = open(outputName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+	if (outputFd < 0) {
+		close(inputFd);
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after re-key.");
+	}
+
+	std::array<unsigned char, 16> oldChain;
+	std::array<unsigned char, 16> newChain;
+	ANGELITA128_ChunkTransform transform = [this, &newCipher, cbc, &oldChain, &newChain, threadCount](unsigned char* buffer, size_t length, bool lastChunk) {
+		this->decryptBlocks(buffer, length / 16, cbc, oldChain, threadCount);
+		if (lastChunk) {
+			unsigned int paddingSize = buffer[length - 1];
+			if (paddingSize == 0 || paddingSize > 16) {
+				throw ANGELITA128_Exception("ANGELITA128: Invalid padding after decrypt, wrong key or mode.");
+			}
+		}
+		newCipher.encryptBlocks(buffer, length / 16, cbc, newChain, threadCount);
+		return length;
+	};
+
+	try {
+		std::uint64_t offset = 0;
+		if (cbc) {
+			ANGELITA128_IO::readAt(inputFd, oldChain.data(), 16, 0);
+			newChain = newCipher.newIV();
+			ANGELITA128_IO::writeAt(outputFd, newChain.data(), 16, 0);
+			offset = 16;
+		}
+		ANGELITA128_IO::create(this->ioBackend)->run(inputFd, offset, outputFd, offset, this->chunkSize, transform);
+	}
+	catch (...) {
+		close(inputFd);
+		close(outputFd);
+		unlink(outputName.c_str());
+		throw;
+	}
+	close(inputFd);
+	if (close(outputFd) != 0) {
+		unlink(outputName.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not write file after re-key.");
+	}
+	if (std::rename(outputName.c_str(), file.c_str()) != 0) {
+		unlink(outputName.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not rename file after re-key.");
+	}
+}
+
+void ANGELITA128::rekeyChunked(std::string file, ANGELITA128& newCipher, unsigned int threadCount) const {
+	//Re-key a chunked container, the chunks of a batch are re-keyed in parallel and keep their offsets and lengths
+	if (!this->keySet || !newCipher.keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Old and new keys must be set to re-key.");
+	}
+	threadCount = resolveThreadCount(threadCount);
+
+	int inputFd = open(file.c_str(), O_RDONLY);
+	if (inputFd < 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for read and re-key.");
+	}
+	ANGELITA128_ContainerHeader header;
+	std::vector<ANGELITA128_ChunkEntry> entries;
+	try {
+		header = ANGELITA128_Container::readHeader(inputFd);
+		entries = ANGELITA128_Container::readIndex(inputFd, header);
+	}
+	catch (...) {
+		close(inputFd);
+		throw;
+	}
+	std::string mode = ANGELITA128_Container::modeName(header.mode);
+	struct stat inputStat;
+	fstat(inputFd, &inputStat);
+	std::string outputName = file + ".ANGELITA128_rekey";
+	int outputFd = open(outputName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, inputStat.st_mode & 0777);
+	if (outputFd < 0) {
+		close(inputFd);
+		throw ANGELITA128_Exception("ANGELITA128: Could not open file for write after re-key.");
+	}
+
+	//GLORIA borrows the S-Box and P-Box, so it runs before the chunk threads
+	std::array<unsigned char, 16> firstIV = newCipher.newIV();
+
+	try {
+		size_t batchChunks = threadCount * 4;
+		std::vector<std::vector<unsigned char>> stored(batchChunks, std::vector<unsigned char>(header.chunkSize + ANGELITA128_Container::CHUNK_SPARE));
+		std::vector<std::vector<unsigned char>> plaintexts(batchChunks, std::vector<unsigned char>(header.chunkSize + 16));
+		bool checksum = header.flags & ANGELITA128_Container::FLAG_CHECKSUM;
+		std::vector<std::uint32_t> chunkChecksums(batchChunks);
+		std::uint32_t plaintextChecksum = 0;
+		for (std::uint64_t batchStart = 0; batchStart < header.chunkCount; batchStart += batchChunks) {
+			size_t count = std::min<std::uint64_t>(batchChunks, header.chunkCount - batchStart);
+			for (size_t k = 0; k < count; k++) {
+				const ANGELITA128_ChunkEntry& entry = entries[batchStart + k];
+				ANGELITA128_IO::readAt(inputFd, stored[k].data(), entry.storedLength, entry.offset);
+			}
+			parallelFor(count, threadCount, [&](size_t k) {
+				ANGELITA128_ChunkEntry& entry = entries[batchStart + k];
+				this->decryptChunk(mode, stored[k].data(), plaintexts[k].data(), entry, header.codec);
+				if (checksum) {
+					chunkChecksums[k] = ANGELITA128_Checksum::crc32c(0, plaintexts[k].data(), entry.plainLength);
+				}
+				entry.IV = newCipher.chunkIV(firstIV, batchStart + k);
+				newCipher.encryptChunk(mode, plaintexts[k].data(), stored[k].data(), entry, header.codec);
+			});
+			for (size_t k = 0; k < count; k++) {
+				const ANGELITA128_ChunkEntry& entry = entries[batchStart + k];
+				if (checksum) {
+					plaintextChecksum = ANGELITA128_Checksum::combine(plaintextChecksum, chunkChecksums[k], entry.plainLength);
+				}
+				ANGELITA128_IO::writeAt(outputFd, stored[k].data(), entry.storedLength, entry.offset);
+			}
+		}
+		//A checksummed container catches a wrong old key in ctr mode too, before anything replaces the file
+		if (checksum && plaintextChecksum != header.checksum) {
+			throw ANGELITA128_Exception("ANGELITA128: Plaintext checksum does not match, wrong key or damaged container.");
+		}
+		ANGELITA128_Container::writeIndex(outputFd, header, entries);
+		ANGELITA128_Container::writeHeader(outputFd, header);
+	}
+	catch (...) {
+		close(inputFd);
+		close(outputFd);
+		unlink(outputName.c_str());
+		throw;
+	}
+	close(inputFd);
+	if (close(outputFd) != 0) {
+		unlink(outputName.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not write file after re-key.");
+	}
+	if (std::rename(outputName.c_str(), file.c_str()) != 0) {
+		unlink(outputName.c_str());
+		throw ANGELITA128_Exception("ANGELITA128: Could not rename file after re-key.");
+	}
+}
@@ -0,0 +1,286 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 scheduler methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 work-stealing scheduler methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_Scheduler.h"
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include <unistd.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct ANGELITA128_Scheduler::Job {
+	//One call's work: a deque of ranges for each thread taking part, the caller's is slot 0
+	struct Slot {
+		std::mutex lock;
+		std::deque<std::pair<size_t, size_t>> ranges;
+	};
+	std::vector<Slot> slots;
+	size_t minGrain;
+	const std::function<void(size_t, size_t)>& work;
+	//Under the scheduler's lock: slots handed out, and threads still working on it
+	unsigned int joined = 1;
+	unsigned int active = 1;
+	std::condition_variable finished;
+	std::atomic<bool> failed;
+	std::exception_ptr failure;
+
+	Job(unsigned int slotCount, size_t minGrain, const std::function<void(size_t, size_t)>& work) : slots(slotCount), minGrain(minGrain), work(work), failed(0) {}
+};
+
+ANGELITA128_Scheduler& ANGELITA128_Scheduler::shared() {
+	static ANGELITA128_Scheduler scheduler;
+	return scheduler;
+}
+
+ANGELITA128_Scheduler::~ANGELITA128_Scheduler() {
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->stopping = 1;
+	}
+	this->jobsReady.notify_all();
+	for (std::thread& thread : this->threads) {
+		thread.join();
+	}
+}
+
+unsigned int ANGELITA128_Scheduler::threadCount() {
+	std::lock_guard<std::mutex> guard(this->lock);
+	if (this->defaultThreads > 0) {
+		return this->defaultThreads;
+	}
+	return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void ANGELITA128_Scheduler::setThreadCount(unsigned int threadCount) {
+	//0 goes back to one per core
+	std::lock_guard<std::mutex> guard(this->lock);
+	this->defaultThreads = threadCount;
+}
+
+void ANGELITA128_Scheduler::setAffinity(std::vector<unsigned int> cores) {
+	//The threads already running are moved now, the ones started later as they start
+#ifdef __linux__
+	long coreCount = sysconf(_SC_NPROCESSORS_CONF);
+	for (unsigned int core : cores) {
+		if (core >= CPU_SETSIZE || (coreCount > 0 && core >= coreCount)) {
+			throw ANGELITA128_Exception("ANGELITA128: No such core to pin the scheduler threads to.");
+		}
+	}
+	std::lock_guard<std::mutex> guard(this->lock);
+	this->cores = cores;
+	for (unsigned int t = 0; t < this->threads.size(); t++) {
+		this->pin(this->threads[t], t);
+	}
+#else
+	if (!cores.empty()) {
+		throw ANGELITA128_Exception("ANGELITA128: Pinning threads to cores is not available on this system.");
+	}
+#endif
+}
+
+void ANGELITA128_Scheduler::pin(std::thread& thread, unsigned int index) {
+	//Pin one pool thread to its core from the list, or to all of them with no list
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (this->cores.empty()) {
+		for (unsigned int core = 0; core < CPU_SETSIZE; core++) {
+			CPU_SET(core, &set);
+		}
+	}
+	else {
+		CPU_SET(this->cores[index % this->cores.size()], &set);
+	}
+	if (pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not pin the scheduler threads to the given cores.");
+	}
+#endif
+}
+
+void ANGELITA128_Scheduler::startThreads(unsigned int count) {
+	//Grow the pool to count threads, called with the lock held
+	while (this->threads.size() < count) {
+		this->threads.emplace_back(&ANGELITA128_Scheduler::serve, this);
+		if (!this->cores.empty()) {
+			this->pin(this->threads.back(), this->threads.size() - 1);
+		}
+	}
+}
+
+void ANGELITA128_Scheduler::serve() {
+	//Pool thread: join calls that still have a free slot, until the scheduler goes at exit
+	std::unique_lock<std::mutex> guard(this->lock);
+	for (;;) {
+		this->jobsReady.wait(guard, [&]() { return this->stopping || !this->jobs.empty(); });
+		if (this->stopping) {
+			return;
+		}
+		std::shared_ptr<Job> job = this->jobs.front();
+		unsigned int slot = job->joined++;
+		job->active++;
+		if (job->joined == job->slots.size()) {
+			this->jobs.erase(this->jobs.begin());
+		}
+		guard.unlock();
+		runWorker(*job, slot);
+		guard.lock();
+		if (--job->active == 0) {
+			job->finished.notify_all();
+		}
+	}
+}
+
+void ANGELITA128_Scheduler::runWorker(Job& job, unsigned int slot) {
+	//Work through slot's own ranges, then steal, until there is nothing left anywhere or something has thrown
+	Job::Slot& own = job.slots[slot];
+	for (;;) {
+		if (job.failed) {
+			return;
+		}
+		std::pair<size_t, size_t> range;
+		bool found = 0;
+		{
+			std::lock_guard<std::mutex> guard(own.lock);
+			if (!own.ranges.empty()) {
+				//Halve down to the grain, the far halves go back on the front, next for this thread and last for thieves
+				range = own.ranges.front();
+				own.ranges.pop_front();
+				while (range.second - range.first >= 2 * job.minGrain) {
+					size_t middle = range.first + (range.second - range.first) / 2;
+					own.ranges.push_front(std::make_pair(middle, range.second));
+					range.second = middle;
+				}
+				found = 1;
+			}
+		}
+		if (!found) {
+			//Take the back half of the last range another thread has, the biggest piece it has left
+			for (unsigned int v = 1; v < job.slots.size() && !found; v++) {
+				Job::Slot& victim = job.slots[(slot + v) % job.slots.size()];
+				std::lock_guard<std::mutex> guard(victim.lock);
+				if (victim.ranges.empty()) {
+					continue;
+				}
+				range = victim.ranges.back();
+				if (range.second - range.first >= 2 * job.minGrain) {
+					size_t middle = range.first + (range.second - range.first) / 2;
+					victim.ranges.back().second = middle;
+					range.first = middle;
+				}
+				else {
+					victim.ranges.pop_back();
+				}
+				found = 1;
+			}
+			if (!found) {
+				return;
+			}
+			std::lock_guard<std::mutex> guard(own.lock);
+			own.ranges.push_front(range);
+			continue;
+		}
+		try {
+			job.work(range.first, range.second);
+		}
+		catch (...) {
+			if (!job.failed.exchange(1)) {
+				job.failure = std::current_exception();
+			}
+			return;
+		}
+	}
+}
+
+void ANGELITA128_Scheduler::forRange(size_t count, unsigned int threadCount, size_t minGrain, const std::function<void(size_t begin, size_t end)>& work) {
+	if (count == 0) {
+		return;
+	}
+	minGrain = std::max<size_t>(minGrain, 1);
+	if (threadCount == 0) {
+		threadCount = this->threadCount();
+	}
+	size_t pieces = (count + minGrain - 1) / minGrain;
+	if (threadCount > pieces) {
+		threadCount = pieces;
+	}
+	if (threadCount <= 1) {
+		work(0, count);
+		return;
+	}
+
+	//A few blocks for each thread to start with, dealt out in turn, so the threads start spread over the range
+	auto job = std::make_shared<Job>(threadCount, minGrain, work);
+	size_t blocks = std::min<size_t>(pieces, (size_t)threadCount * 4);
+	size_t blockSize = ((count + blocks - 1) / blocks + minGrain - 1) / minGrain * minGrain;
+	size_t block = 0;
+	for (size_t begin = 0; begin < count; begin += blockSize, block++) {
+		job->slots[block % threadCount].ranges.push_back(std::make_pair(begin, std::min(begin + blockSize, count)));
+	}
+	{
+		std::lock_guard<std::mutex> guard(this->lock);
+		this->startThreads(std::max<size_t>(this->threads.size(), threadCount - 1));
+		this->jobs.push_back(job);
+	}
+	this->jobsReady.notify_all();
+
+	runWorker(*job, 0);
+	{
+		//No more threads join once the caller is done, it waits for the ones still finishing a range
+		std::unique_lock<std::mutex> guard(this->lock);
+		auto open = std::find(this->jobs.begin(), this->jobs.end(), job);
+		if (open != this->jobs.end()) {
+			this->jobs.erase(open);
+		}
+		job->active--;
+		job->finished.wait(guard, [&]() { return job->active == 0; });
+	}
+	if (job->failure) {
+		std::rethrow_exception(job->failure);
+	}
+}
+
+void ANGELITA128_Scheduler::forEach(size_t count, unsigned int threadCount, const std::function<void(size_t)>& work) {
+	this->forRange(count, threadCount, 1, [&work](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			work(i);
+		}
+	});
+}
@@ -0,0 +1,98 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 scheduler header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 work-stealing scheduler class
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+/*
+	The scheduler behind every parallel call in the library: one pool of threads for the whole process, started as
+	calls first need them and kept for the next ones.
+
+	A call hands out its range of work items in blocks, one after the other to each thread's deque. A thread takes
+	from the front of its own deque and halves what it takes down to the call's grain, putting the other halves back
+	on the front. A thread with nothing left takes the back half of the last range in another's deque. A skewed call
+	(one huge file among many small ones) keeps every thread busy to the end that way, and the pieces are large while
+	there is plenty left and get down to the grain at the end.
+
+	The calling thread works on its own call as one of the threads, so a call always finishes, even when the pool
+	threads are busy with other calls or it is made from inside one.
+*/
+
+#ifndef ANGELITA128_SCHEDULER_H
+#define ANGELITA128_SCHEDULER_H
+
+#include "ANGELITA128_Exception.h"
+#include <functional>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstddef>
+
+class ANGELITA128_Scheduler {
+private:
+	struct Job;
+
+	std::mutex lock;
+	std::condition_variable jobsReady;
+	std::vector<std::thread> threads;
+	std::vector<std::shared_ptr<Job>> jobs;
+	std::vector<unsigned int> cores;
+	unsigned int defaultThreads = 0;
+	bool stopping = 0;
+
+	ANGELITA128_Scheduler() {}
+	void serve();
+	void startThreads(unsigned int count);
+	void pin(std::thread& thread, unsigned int index);
+	static void runWorker(Job& job, unsigned int slot);
+
+public:
+	~ANGELITA128_Scheduler();
+	ANGELITA128_Scheduler(const ANGELITA128_Scheduler&) = delete;
+	ANGELITA128_Scheduler& operator=(const ANGELITA128_Scheduler&) = delete;
+
+	static ANGELITA128_Scheduler& shared();
+
+	//Run work over [0, count) in ranges of at least minGrain items (but the last) on up to threadCount threads,
+	//the calling one included; threadCount 0 for threadCount(). The first exception thrown is passed on once the threads are done
+	void forRange(size_t count, unsigned int threadCount, size_t minGrain, const std::function<void(size_t begin, size_t end)>& work);
+	//work(0) to work(count - 1), one item at a time
+	void forEach(size_t count, unsigned int threadCount, const std::function<void(size_t)>& work);
+
+	//What a thread count of 0 means: the count set, or one per core
+	unsigned int threadCount();
+	void setThreadCount(unsigned int threadCount);
+	//Pin the pool threads to these CPUs, one after the other, or let them run anywhere with an empty list
+	void setAffinity(std::vector<unsigned int> cores);
+};
+
+#endif
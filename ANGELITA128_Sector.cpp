@@ -0,0 +1,132 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 sector mode methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 sector mode methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128.h"
+#include "ANGELITA128_Scheduler.h"
+#include <cstring>
+
+//XTS as in IEEE 1619, with ANGELITA128 as the block cipher:
+//	T[0] = E2(sector number, 64-bit little endian, zero filled)
+//	C[j] = E1(P[j] ^ T[j]) ^ T[j],  T[j + 1] = T[j] * x in GF(2^128), little endian
+//Sectors are whole blocks, so there is no ciphertext stealing.
+
+//The batch calls hand the threads at least this many bytes of sectors at a time
+static const size_t SECTOR_GRAIN = 65536;
+
+static void doubleTweak(unsigned char* tweak) {
+	//Multiply by x in GF(2^128), little endian, x^128 = x^7 + x^2 + x + 1
+	unsigned char carry = tweak[15] >> 7;
+	for (unsigned int i = 15; i > 0; i--) {
+		tweak[i] = (tweak[i] << 1) | (tweak[i - 1] >> 7);
+	}
+	tweak[0] = (tweak[0] << 1) ^ (carry * 0x87);
+}
+
+void ANGELITA128::checkSectorKeys(size_t sectorSize, const ANGELITA128& tweakCipher) const {
+	//Both keys set and different, and whole blocks
+	if (!this->keySet || !tweakCipher.keySet) {
+		throw ANGELITA128_Exception("ANGELITA128: Key and tweak key must be set for the sector mode.");
+	}
+	if (this->initialKey0 == tweakCipher.initialKey0) {
+		throw ANGELITA128_Exception("ANGELITA128: Tweak key must be different from the key for the sector mode.");
+	}
+	if (sectorSize == 0 || sectorSize % 16 != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Sector size must be a multiple of 16 bytes.");
+	}
+}
+
+void ANGELITA128::sectorBlocks(unsigned char* sector, size_t sectorSize, std::uint64_t sectorNumber, const ANGELITA128& tweakCipher, bool encrypting) const {
+	//Encrypt or decrypt one sector in place, the tweaks of a lane group are made first and the group goes through the lanes together
+	unsigned char tweak[16] = {};
+	for (unsigned int i = 0; i < 8; i++) {
+		tweak[i] = (sectorNumber >> (8 * i)) & 255;
+	}
+	tweakCipher.encryptLanes(tweak, 1);
+
+	unsigned char tweaks[256];
+	unsigned char laneBlocks[256];
+	size_t blockCount = sectorSize / 16;
+	while (blockCount > 0) {
+		unsigned int lanes = blockCount < this->laneCount ? blockCount : this->laneCount;
+		for (unsigned int lane = 0; lane < lanes; lane++) {
+			std::memcpy(tweaks + lane * 16, tweak, 16);
+			doubleTweak(tweak);
+		}
+		for (unsigned int i = 0; i < lanes * 16; i++) {
+			laneBlocks[i] = sector[i] ^ tweaks[i];
+		}
+		if (encrypting) {
+			this->encryptLanes(laneBlocks, lanes);
+		}
+		else {
+			this->decryptLanes(laneBlocks, lanes);
+		}
+		for (unsigned int i = 0; i < lanes * 16; i++) {
+			sector[i] = laneBlocks[i] ^ tweaks[i];
+		}
+		sector += lanes * 16;
+		blockCount -= lanes;
+	}
+}
+
+void ANGELITA128::encryptSector(unsigned char* sector, size_t sectorSize, std::uint64_t sectorNumber, const ANGELITA128& tweakCipher) const {
+	this->checkSectorKeys(sectorSize, tweakCipher);
+	this->sectorBlocks(sector, sectorSize, sectorNumber, tweakCipher, 1);
+}
+
+void ANGELITA128::decryptSector(unsigned char* sector, size_t sectorSize, std::uint64_t sectorNumber, const ANGELITA128& tweakCipher) const {
+	this->checkSectorKeys(sectorSize, tweakCipher);
+	this->sectorBlocks(sector, sectorSize, sectorNumber, tweakCipher, 0);
+}
+
+void ANGELITA128::encryptSectors(unsigned char* sectors, size_t sectorSize, std::uint64_t firstSector, size_t sectorCount, const ANGELITA128& tweakCipher, unsigned int threadCount) const {
+	//Every sector stands alone, so they are shared out over the threads in runs of at least SECTOR_GRAIN bytes
+	this->checkSectorKeys(sectorSize, tweakCipher);
+	ANGELITA128_Scheduler::shared().forRange(sectorCount, resolveThreadCount(threadCount), SECTOR_GRAIN / sectorSize, [&](size_t first, size_t end) {
+		for (size_t n = first; n < end; n++) {
+			this->sectorBlocks(sectors + n * sectorSize, sectorSize, firstSector + n, tweakCipher, 1);
+		}
+	});
+}
+
+void ANGELITA128::decryptSectors(unsigned char* sectors, size_t sectorSize, std::uint64_t firstSector, size_t sectorCount, const ANGELITA128& tweakCipher, unsigned int threadCount) const {
+	this->checkSectorKeys(sectorSize, tweakCipher);
+	ANGELITA128_Scheduler::shared().forRange(sectorCount, resolveThreadCount(threadCount), SECTOR_GRAIN / sectorSize, [&](size_t first, size_t end) {
+		for (size_t n = first; n < end; n++) {
+			this->sectorBlocks(sectors + n * sectorSize, sectorSize, firstSector + n, tweakCipher, 0);
+		}
+	});
+}
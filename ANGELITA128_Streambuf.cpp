@@ -0,0 +1,211 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file containing the ANGELITA128 stream buffer methods
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 stream buffer methods
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+
+
+#include "ANGELITA128_Streambuf.h"
+#include <cstring>
+
+static bool checkStreamMode(const ANGELITA128& cipher, std::string mode, size_t& bufferSize) {
+	//Shared checks for both stream buffers, returns whether the mode is cbc
+	if (!cipher.hasKey()) {
+		throw ANGELITA128_Exception("ANGELITA128: Key must be set to use a stream buffer.");
+	}
+	if (mode != "ecb" && mode != "cbc") {
+		throw ANGELITA128_Exception("ANGELITA128: Invalid stream mode, must be \"ecb\" or \"cbc\".");
+	}
+	//Whole blocks only, and at least one
+	bufferSize -= bufferSize % 16;
+	if (bufferSize == 0) {
+		bufferSize = 16;
+	}
+	return mode == "cbc";
+}
+
+ANGELITA128_EncryptBuf::ANGELITA128_EncryptBuf(ANGELITA128& cipher, std::streambuf* sink, std::string mode, size_t bufferSize)
+	: cipher(cipher), sink(sink) {
+	this->cbc = checkStreamMode(cipher, mode, bufferSize);
+	this->buffer.resize(bufferSize + 16);
+	this->setp((char*)this->buffer.data(), (char*)this->buffer.data() + bufferSize);
+	if (this->cbc) {
+		this->chainBlock = cipher.newIV();
+		if (this->sink->sputn((const char*)this->chainBlock.data(), 16) != 16) {
+			throw ANGELITA128_Exception("ANGELITA128: Could not write to the stream after encrypt.");
+		}
+	}
+}
+
+ANGELITA128_EncryptBuf::~ANGELITA128_EncryptBuf() {
+	try {
+		this->close();
+	}
+	catch (...) {
+	}
+}
+
+void ANGELITA128_EncryptBuf::writeBlocks() {
+	//Encrypt and write the whole blocks in the buffer, the bytes past them move to the front
+	unsigned char* start = (unsigned char*)this->pbase();
+	size_t length = this->pptr() - this->pbase();
+	size_t wholeLength = length - length % 16;
+	if (this->cbc) {
+		this->cipher.encryptCBC(start, start, wholeLength / 16, this->chainBlock);
+	}
+	else {
+		this->cipher.encryptECB(start, start, wholeLength / 16);
+	}
+	if (this->sink->sputn((const char*)start, wholeLength) != (std::streamsize)wholeLength) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not write to the stream after encrypt.");
+	}
+	std::memmove(start, start + wholeLength, length - wholeLength);
+	this->setp((char*)start, (char*)start + this->buffer.size() - 16);
+	this->pbump(length - wholeLength);
+}
+
+ANGELITA128_EncryptBuf::int_type ANGELITA128_EncryptBuf::overflow(int_type c) {
+	//The buffer is full, so it is all whole blocks
+	if (this->closed) {
+		return traits_type::eof();
+	}
+	this->writeBlocks();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*this->pptr() = traits_type::to_char_type(c);
+		this->pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+int ANGELITA128_EncryptBuf::sync() {
+	//Write out what can be without padding, up to 15 bytes stay until more arrive or close()
+	if (this->closed) {
+		return 0;
+	}
+	this->writeBlocks();
+	return this->sink->pubsync();
+}
+
+void ANGELITA128_EncryptBuf::close() {
+	//Use padding to make 16n blocks even
+	if (this->closed) {
+		return;
+	}
+	this->writeBlocks();
+	this->closed = 1;
+	unsigned int paddingSize = 16 - (this->pptr() - this->pbase());
+	std::memset(this->pptr(), paddingSize, paddingSize);
+	this->pbump(paddingSize);
+	this->writeBlocks();
+	this->setp(nullptr, nullptr);
+	if (this->sink->pubsync() != 0) {
+		throw ANGELITA128_Exception("ANGELITA128: Could not write to the stream after encrypt.");
+	}
+}
+
+ANGELITA128_DecryptBuf::ANGELITA128_DecryptBuf(const ANGELITA128& cipher, std::streambuf* source, std::string mode, size_t bufferSize)
+	: cipher(cipher), source(source) {
+	this->cbc = checkStreamMode(cipher, mode, bufferSize);
+	this->buffer.resize(bufferSize + 16);
+}
+
+size_t ANGELITA128_DecryptBuf::readSource(unsigned char* destination, size_t length) {
+	//Read until length bytes or the end of the source
+	size_t done = 0;
+	while (done < length) {
+		std::streamsize got = this->source->sgetn((char*)destination + done, length - done);
+		if (got <= 0) {
+			break;
+		}
+		done += got;
+	}
+	return done;
+}
+
+ANGELITA128_DecryptBuf::int_type ANGELITA128_DecryptBuf::underflow() {
+	//Decrypt the next buffer of ciphertext, the last block is always held back
+	//until the next read shows whether it is the padded one
+	if (this->gptr() < this->egptr()) {
+		return traits_type::to_int_type(*this->gptr());
+	}
+	if (this->finished) {
+		return traits_type::eof();
+	}
+	if (!this->started) {
+		this->started = 1;
+		if (this->cbc && this->readSource(this->chainBlock.data(), 16) != 16) {
+			throw ANGELITA128_Exception("ANGELITA128: Stream length is not valid for decrypt, stream is not encrypted in this mode.");
+		}
+	}
+
+	unsigned char* ciphertext = this->buffer.data() + 16;
+	size_t length = this->readSource(ciphertext, this->buffer.size() - 16);
+	if (length % 16 != 0 || (length == 0 && !this->holding)) {
+		throw ANGELITA128_Exception("ANGELITA128: Stream length is not valid for decrypt, stream is not encrypted in this mode.");
+	}
+	if (length == 0) {
+		//The held block was the last one, get the padding size and remove the padding from decrypted output
+		this->finished = 1;
+		unsigned int paddingSize = this->heldBlock[15];
+		if (paddingSize == 0 || paddingSize > 16) {
+			throw ANGELITA128_Exception("ANGELITA128: Invalid padding after decrypt, wrong key or mode.");
+		}
+		this->holding = 0;
+		if (paddingSize == 16) {
+			return traits_type::eof();
+		}
+		std::memcpy(this->buffer.data(), this->heldBlock.data(), 16 - paddingSize);
+		this->setg((char*)this->buffer.data(), (char*)this->buffer.data(), (char*)this->buffer.data() + 16 - paddingSize);
+		return traits_type::to_int_type(*this->gptr());
+	}
+
+	if (this->cbc) {
+		this->cipher.decryptCBC(ciphertext, ciphertext, length / 16, this->chainBlock);
+	}
+	else {
+		this->cipher.decryptECB(ciphertext, ciphertext, length / 16);
+	}
+	unsigned char* start = ciphertext;
+	if (this->holding) {
+		start = this->buffer.data();
+		std::memcpy(start, this->heldBlock.data(), 16);
+	}
+	std::memcpy(this->heldBlock.data(), ciphertext + length - 16, 16);
+	this->holding = 1;
+	unsigned char* end = ciphertext + length - 16;
+	if (start == end) {
+		//Only the one block so far, it is held, so read on
+		return this->underflow();
+	}
+	this->setg((char*)start, (char*)start, (char*)end);
+	return traits_type::to_int_type(*this->gptr());
+}
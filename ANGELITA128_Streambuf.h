@@ -0,0 +1,99 @@
+/*
+    This is part of the ANGELITA128 encryption system, the source code file for the ANGELITA128 stream buffer header
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	ANGELITA128: Algorithm of Number Generation and Encryption Lightweight Intersperse Transform Automator 128-Bit
+
+	Project Start date: 5-10-2022
+	Project Completed: 7-20-2022
+	Modified for Linux: 12-02-2022
+
+	ANGELITA128 stream buffer classes
+
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+	Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+	for any real secure purposes. You have been warned!
+	!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+#ifndef ANGELITA128_STREAMBUF_H
+#define ANGELITA128_STREAMBUF_H
+
+#include "ANGELITA128.h"
+#include <streambuf>
+
+//Stream buffers that encrypt what is written through them, or decrypt what is read through them,
+//in the same layout as the ".ANGELITA128" files ("ecb", or "cbc" with the IV first).
+//They wrap another streambuf, which must outlive them, as must the keyed cipher:
+//	std::ofstream file("data.ANGELITA128", std::ios::binary);
+//	ANGELITA128_EncryptBuf encryptBuf(a1, file.rdbuf(), "cbc");
+//	std::ostream out(&encryptBuf);
+
+class ANGELITA128_EncryptBuf : public std::streambuf {
+private:
+	const ANGELITA128& cipher;
+	std::streambuf* sink;
+	bool cbc;
+	std::array<unsigned char, 16> chainBlock;
+	std::vector<unsigned char> buffer;
+	bool closed = 0;
+
+	void writeBlocks();
+
+protected:
+	int_type overflow(int_type c) override;
+	int sync() override;
+
+public:
+	//The IV for cbc comes from the cipher's GLORIA and is written to the sink straight away
+	ANGELITA128_EncryptBuf(ANGELITA128& cipher, std::streambuf* sink, std::string mode, size_t bufferSize = 65536);
+	//Closes if close() wasn't called, but any error is lost, so call close() to see it
+	~ANGELITA128_EncryptBuf();
+	ANGELITA128_EncryptBuf(const ANGELITA128_EncryptBuf&) = delete;
+	ANGELITA128_EncryptBuf& operator=(const ANGELITA128_EncryptBuf&) = delete;
+
+	//Write the padded last block and flush the sink, nothing more can be written after
+	void close();
+};
+
+class ANGELITA128_DecryptBuf : public std::streambuf {
+private:
+	const ANGELITA128& cipher;
+	std::streambuf* source;
+	bool cbc;
+	std::array<unsigned char, 16> chainBlock;
+	//Ciphertext is read in after a 16 byte gap, where the block held back from the last read goes
+	std::vector<unsigned char> buffer;
+	std::array<unsigned char, 16> heldBlock;
+	bool holding = 0;
+	bool started = 0;
+	bool finished = 0;
+
+	size_t readSource(unsigned char* destination, size_t length);
+
+protected:
+	int_type underflow() override;
+
+public:
+	//A bad length or padding at the end of the source throws from the read, which the istream shows as badbit
+	ANGELITA128_DecryptBuf(const ANGELITA128& cipher, std::streambuf* source, std::string mode, size_t bufferSize = 65536);
+	ANGELITA128_DecryptBuf(const ANGELITA128_DecryptBuf&) = delete;
+	ANGELITA128_DecryptBuf& operator=(const ANGELITA128_DecryptBuf&) = delete;
+};
+
+#endif
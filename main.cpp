@@ -1,5 +1,5 @@
 /*
-    This is part of the ANGELITA128 encryption system, the example main for using it
+    This is part of the ANGELITA128 encryption system, the command line for encrypting streams
     Copyright (C) 2022 stringzzz, Ghostwarez Co.
 
     This program is free software: you can redistribute it and/or modify
@@ -18,11 +18,20 @@
 
 /*
 
-This main file in particular is just to show how to properly use the ANGELITA128 class and catch any errors
-Uncomment lines and compile to use the different features
+angelita128, the command line: encrypts or decrypts standard input to standard output
 
-I just supplied the encryption system, it is up to the user to create a more useful interface or 
-do essentially whatever they want with it.
+Usage:
+    angelita128 enc|dec [-m ecb|cbc] (-K <key file> | -k <32 digit hex key>) [-c chunk bytes] [-b backend] [-s]
+    angelita128 genkey <key file>
+
+The key file holds the key as 32 hex digits, as written by genkey, which takes it from getrandom(), makes it readable by its owner only
+and won't overwrite a file that is already there. cbc is the default mode.
+The output has the same layout as the ".ANGELITA128" files, so the two can be mixed, and only the chunk buffers are held
+in memory, so it can sit in the middle of a pipeline:
+    tar cf - photos | angelita128 enc -K photos.key | ssh backup 'cat > photos.tar.ANGELITA128'
+-c sets the chunk size (a multiple of 16, 1 MiB by default), -b the I/O backend ("auto", "pipeline", "blocking", "io_uring"),
+and -s reports the bytes and bytes per second on standard error once done.
+On a failure, including a wrong key found at the end of decrypting, the exit status is 1.
 
 !!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
 Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
@@ -64,42 +73,151 @@ for any real secure purposes. You have been warned!
 */
 
 #include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/random.h>
 #include "ANGELITA128.h"
 
-int main() {
+static void usage() {
+    std::cerr << "Usage: angelita128 enc|dec [-m ecb|cbc] (-K <key file> | -k <hex key>) [-c chunk bytes] [-b backend] [-s]\n";
+    std::cerr << "       angelita128 hash (-K <key file> | -k <hex key>) [-t threads] <file>...\n";
+    std::cerr << "       angelita128 genkey <key file>\n";
+    exit(1);
+}
+
+static std::string readKeyFile(const std::string& keyFile) {
+    //The hex key is the first word in the file
+    std::ifstream keyStream(keyFile);
+    std::string hexKey;
+    if (!keyStream || !(keyStream >> hexKey)) {
+        throw ANGELITA128_Exception("ANGELITA128: Could not read key file.");
+    }
+    return hexKey;
+}
+
+static std::string toHex(const std::array<unsigned char, 16>& bytes) {
+    const char* digits = "0123456789abcdef";
+    std::string hex;
+    for (unsigned char byte : bytes) {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 15];
+    }
+    return hex;
+}
+
+int main(int argc, char* argv[]) {
     try {
         srand(time(0)); //Do here, not in functions
         ANGELITA128 a1;
 
-        /*
-        //Example encrypt:    
-        std::cout << "Encrypting...\n";
-        a1.genKey();  //GLORIA PRNG Key
-        a1.showKey(); //Show generated key in hex
-        //a1.setKeyH("e5077dce18a81e4e80a6df19b64dcf25");
-        a1.encrypt("n1.jpg", "cbc");
-        a1.encrypt("t1.txt", "cbc");
-        std::cout << "Encryption complete.\n";
-        */
-        
-
-        /*
-        //Example decrypt:
-        std::cout << "Decrypting...\n";
-        a1.setKeyH("fc40b62504a352698356a0e4ebfebf38");
-        a1.decrypt("n1.jpg.ANGELITA128", "cbc");
-        a1.decrypt("t1.txt.ANGELITA128", "cbc");
-        std::cout << "Decryption complete\n";
-        */
-
-        //Detect errors:
-        //a1.setKeyH("e5077dce18a81e4e80a6df19b64dcf255"); //Hex key too long
-        //a1.setKeyH("e5077dce18a81e4e80a6df19b64dcf2"); //Hex key too short
-        //a1.encrypt("n1.txt", "abc"); //Invalid encrypt mode, must be "ecb" or "cbc"
-       
+        if (argc < 2) {
+            usage();
+        }
+        std::string operation = argv[1];
+        if (operation == "genkey") {
+            if (argc != 3) {
+                usage();
+            }
+            //GLORIA and genKey run on rand(), seeded with the time, so a long-term key comes from the kernel
+            std::array<unsigned char, 16> keyBytes;
+            if (getrandom(keyBytes.data(), keyBytes.size(), 0) != (ssize_t)keyBytes.size()) {
+                throw ANGELITA128_Exception("ANGELITA128: Could not get random bytes for the key.");
+            }
+            //Only the owner may read the key, and an existing key file is never overwritten
+            int keyFd = open(argv[2], O_WRONLY | O_CREAT | O_EXCL, 0600);
+            if (keyFd < 0) {
+                throw ANGELITA128_Exception("ANGELITA128: Could not create key file, it may already exist.");
+            }
+            std::string keyLine = toHex(keyBytes) + "\n";
+            try {
+                ANGELITA128_IO::writeAll(keyFd, (const unsigned char*)keyLine.data(), keyLine.size());
+            }
+            catch (ANGELITA128_Exception& err) {
+                close(keyFd);
+                unlink(argv[2]);
+                throw;
+            }
+            if (close(keyFd) != 0) {
+                unlink(argv[2]);
+                throw ANGELITA128_Exception("ANGELITA128: Could not write key file.");
+            }
+            return 0;
+        }
+        if (operation != "enc" && operation != "dec" && operation != "hash") {
+            usage();
+        }
+
+        std::string mode = "cbc";
+        bool keyGiven = 0;
+        bool showStats = 0;
+        unsigned int threadCount = 0;
+        std::vector<std::string> files;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "-m" && i + 1 < argc) {
+                mode = argv[++i];
+            }
+            else if (arg == "-K" && i + 1 < argc) {
+                a1.setKeyH(readKeyFile(argv[++i]));
+                keyGiven = 1;
+            }
+            else if (arg == "-k" && i + 1 < argc) {
+                a1.setKeyH(argv[++i]);
+                keyGiven = 1;
+            }
+            else if (arg == "-c" && i + 1 < argc) {
+                a1.setChunkSize(std::stoull(argv[++i]));
+            }
+            else if (arg == "-b" && i + 1 < argc) {
+                a1.setIOBackend(argv[++i]);
+            }
+            else if (arg == "-s") {
+                showStats = 1;
+            }
+            else if (arg == "-t" && i + 1 < argc) {
+                threadCount = std::stoul(argv[++i]);
+            }
+            else if (operation == "hash" && arg[0] != '-') {
+                files.push_back(arg);
+            }
+            else {
+                usage();
+            }
+        }
+        if (!keyGiven || (operation == "hash") == files.empty()) {
+            usage();
+        }
+        if (operation == "hash") {
+            //One fingerprint per file, laid out like sha256sum
+            for (const std::string& file : files) {
+                std::cout << toHex(a1.fingerprintFile(file, threadCount)) << "  " << file << "\n";
+            }
+            return 0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::uint64_t bytes;
+        if (operation == "enc") {
+            bytes = a1.encryptStream(STDIN_FILENO, STDOUT_FILENO, mode);
+        }
+        else {
+            bytes = a1.decryptStream(STDIN_FILENO, STDOUT_FILENO, mode);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (showStats) {
+            std::cerr << bytes << " bytes in " << seconds << " s, ";
+            std::cerr << (std::uint64_t)(seconds > 0 ? bytes / seconds : 0) << " bytes/s\n";
+        }
+    }
+    catch (const ANGELITA128_Exception& err) {
+        std::cerr << err.what() << "\n";
+        exit(1);
     }
-    catch (ANGELITA128_Exception err) {
-        std::cout << err.what() << "\n";
+    catch (std::exception& err) {
+        std::cerr << "angelita128: " << err.what() << "\n";
         exit(1);
     }
     return 0;
@@ -0,0 +1,184 @@
+/*
+    This is part of the ANGELITA128 encryption system, the batch main for encrypting many files at once
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+
+Batch command line, encrypts or decrypts a list of files or a whole directory tree on a pool of threads
+
+Usage:
+    ANGELITA128_Batch e|d ecb|cbc -k <32 digit hex key> [-t threads] [-c profile] [-H] [-m] [-r directory] [files...]
+    ANGELITA128_Batch e ecb|cbc -g [-t threads] [-c profile] [-H] [-m] [-r directory] [files...]
+
+-g generates a new key for encryption and shows it, -t 0 (default) uses one thread per core or the profile's count.
+-c uses the tuning profile saved in the file, calibrating this machine and saving one first if it can't be used.
+-H backs large buffers with huge pages, -m shows how the buffer arena was used after the report.
+The exit status is 1 if any file failed, the other files in the batch are still processed.
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+/*
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Key Schedule	Bytes	% Key	Key Bytes	Key Bits
+;
+; S-Box		1216	59.375	9.5		76
+; P-Box		320	15.625	2.5		20
+; XOR1		256	12.5	2		16
+; XOR2		256	12.5	2		16
+; Total		2048	100	16		128
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;; ANGELITA128 Algorithm ;;;;;;;;;;;;;;;;;;;
+; 1. Choose e/d (encryption/decryption)
+; 2. Choose the key option
+; 3. Input or generated key is expanded 128 times by
+;	the key schedule (KISS)
+; 4. The Key Schedule is split, some bytes used
+;	to initialize the S-Box and P-Box. The rest is
+;	used in the encryption/decryption loop
+; 5. The encryption/decryption loop works on 128-Bit
+;	blocks, for 16 cycles. Cycle below (Encryption):
+;
+;	b. XOR with KS 1
+;	c. S-Box
+;	d. XOR with KS 2
+;	e. If cycles is multiple of 2, P-Box the pairs of bits of the block
+;
+;	Decryption is simply the reverse of this
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ANGELITA128.h"
+#include "ANGELITA128_Arena.h"
+
+static void usage() {
+    std::cout << "Usage: ANGELITA128_Batch e|d ecb|cbc (-k <hex key> | -g) [-t threads] [-c profile] [-H] [-m] [-r directory] [files...]\n";
+    exit(1);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        srand(time(0)); //Do here, not in functions
+        if (argc < 4) {
+            usage();
+        }
+
+        //The profile has to be in use before the cipher object is made, it takes its settings from it
+        for (int i = 3; i + 1 < argc; i++) {
+            if (std::string(argv[i]) == "-c") {
+                if (!ANGELITA128::loadProfile(argv[i + 1])) {
+                    std::cout << "Calibrating...\n";
+                    ANGELITA128::calibrate(argv[i + 1]);
+                }
+                ANGELITA128::profile().showProfile();
+                break;
+            }
+        }
+        ANGELITA128 a1;
+        std::string operation = argv[1];
+        std::string mode = argv[2];
+        if (operation != "e" && operation != "d") {
+            usage();
+        }
+
+        bool keyGiven = 0;
+        unsigned int threadCount = 0;
+        bool showMemory = 0;
+        std::string directory;
+        std::vector<std::string> files;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "-k" && i + 1 < argc) {
+                a1.setKeyH(argv[++i]);
+                keyGiven = 1;
+            }
+            else if (arg == "-g" && operation == "e") {
+                a1.genKey();
+                a1.showKey();
+                keyGiven = 1;
+            }
+            else if (arg == "-t" && i + 1 < argc) {
+                threadCount = std::stoul(argv[++i]);
+            }
+            else if (arg == "-c" && i + 1 < argc) {
+                i++;
+            }
+            else if (arg == "-H") {
+                ANGELITA128_Arena::setHugePages(1);
+            }
+            else if (arg == "-m") {
+                showMemory = 1;
+            }
+            else if (arg == "-r" && i + 1 < argc) {
+                directory = argv[++i];
+            }
+            else {
+                files.push_back(arg);
+            }
+        }
+        if (!keyGiven || (directory.empty() && files.empty())) {
+            usage();
+        }
+
+        ANGELITA128_BatchReport report;
+        if (!directory.empty()) {
+            if (operation == "e") {
+                report = a1.encryptDirectory(directory, mode, threadCount);
+            }
+            else {
+                report = a1.decryptDirectory(directory, mode, threadCount);
+            }
+        }
+        if (!files.empty()) {
+            ANGELITA128_BatchReport fileReport;
+            if (operation == "e") {
+                fileReport = a1.encryptBatch(files, mode, threadCount);
+            }
+            else {
+                fileReport = a1.decryptBatch(files, mode, threadCount);
+            }
+            report.results.insert(report.results.end(), fileReport.results.begin(), fileReport.results.end());
+            report.totalBytes += fileReport.totalBytes;
+            report.failures += fileReport.failures;
+            report.seconds += fileReport.seconds;
+            if (fileReport.threadCount > report.threadCount) {
+                report.threadCount = fileReport.threadCount;
+            }
+        }
+        report.showReport();
+        if (showMemory) {
+            ANGELITA128_Arena::showStats();
+        }
+        if (report.failures > 0) {
+            exit(1);
+        }
+    }
+    catch (const ANGELITA128_Exception& err) {
+        std::cout << err.what() << "\n";
+        exit(1);
+    }
+    return 0;
+}
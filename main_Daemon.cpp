@@ -0,0 +1,158 @@
+/*
+    This is part of the ANGELITA128 encryption system, the daemon main for serving encryption over a local socket
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+
+Daemon command line, keeps the expanded keys in memory and serves encrypt/decrypt requests on a Unix domain socket
+
+Usage:
+    ANGELITA128_Daemon <socket> (-K <key file> | -k <32 digit hex key>)... [-t threads]
+    ANGELITA128_Daemon stats <socket>
+
+Each key is served under the id of its place on the command line, counting from 0. -t 0 (default) uses one thread per core.
+SIGINT or SIGTERM stops the daemon and shows its figures; stats asks a running daemon for them.
+
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+Also to note, this system hasn't gone through any kind of proper peer review process yet, so it should not be used
+for any real secure purposes. You have been warned!
+!!!!!!!!!!!!!! VERY IMPORTANT !!!!!!!!!!!
+
+*/
+
+/*
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Key Schedule	Bytes	% Key	Key Bytes	Key Bits
+;
+; S-Box		1216	59.375	9.5		76
+; P-Box		320	15.625	2.5		20
+; XOR1		256	12.5	2		16
+; XOR2		256	12.5	2		16
+; Total		2048	100	16		128
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;; ANGELITA128 Algorithm ;;;;;;;;;;;;;;;;;;;
+; 1. Choose e/d (encryption/decryption)
+; 2. Choose the key option
+; 3. Input or generated key is expanded 128 times by
+;	the key schedule (KISS)
+; 4. The Key Schedule is split, some bytes used
+;	to initialize the S-Box and P-Box. The rest is
+;	used in the encryption/decryption loop
+; 5. The encryption/decryption loop works on 128-Bit
+;	blocks, for 16 cycles. Cycle below (Encryption):
+;
+;	b. XOR with KS 1
+;	c. S-Box
+;	d. XOR with KS 2
+;	e. If cycles is multiple of 2, P-Box the pairs of bits of the block
+;
+;	Decryption is simply the reverse of this
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <csignal>
+#include "ANGELITA128.h"
+#include "ANGELITA128_Daemon.h"
+
+static ANGELITA128_Daemon* runningDaemon = nullptr;
+
+static void usage() {
+    std::cout << "Usage: ANGELITA128_Daemon <socket> (-K <key file> | -k <hex key>)... [-t threads]\n";
+    std::cout << "       ANGELITA128_Daemon stats <socket>\n";
+    exit(1);
+}
+
+static void stopDaemon(int) {
+    if (runningDaemon != nullptr) {
+        runningDaemon->stop();
+    }
+}
+
+static std::string readKeyFile(const std::string& keyFile) {
+    //The hex key is the first word in the file
+    std::ifstream keyStream(keyFile);
+    std::string hexKey;
+    if (!keyStream || !(keyStream >> hexKey)) {
+        throw ANGELITA128_Exception("ANGELITA128: Could not read key file.");
+    }
+    return hexKey;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 3) {
+            usage();
+        }
+        if (std::string(argv[1]) == "stats") {
+            ANGELITA128_DaemonClient client(argv[2]);
+            ANGELITA128_Daemon::showStats(client.stats());
+            return 0;
+        }
+
+        //The daemon keeps pointers to the ciphers, so they each get their own place
+        std::vector<std::unique_ptr<ANGELITA128>> ciphers;
+        std::vector<std::string> keyNames;
+        unsigned int threadCount = 0;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            if ((arg == "-K" || arg == "-k") && i + 1 < argc) {
+                ciphers.push_back(std::make_unique<ANGELITA128>());
+                if (arg == "-K") {
+                    keyNames.push_back(argv[++i]);
+                    ciphers.back()->setKeyH(readKeyFile(keyNames.back()));
+                }
+                else {
+                    keyNames.push_back("key given with -k");
+                    ciphers.back()->setKeyH(argv[++i]);
+                }
+            }
+            else if (arg == "-t" && i + 1 < argc) {
+                threadCount = std::stoul(argv[++i]);
+            }
+            else {
+                usage();
+            }
+        }
+        if (ciphers.empty()) {
+            usage();
+        }
+
+        ANGELITA128_Daemon daemon(argv[1], threadCount);
+        for (size_t k = 0; k < ciphers.size(); k++) {
+            std::cout << "Key id " << daemon.addKey(*ciphers[k]) << ": " << keyNames[k] << "\n";
+        }
+        runningDaemon = &daemon;
+        signal(SIGINT, stopDaemon);
+        signal(SIGTERM, stopDaemon);
+        std::cout << "Serving on " << argv[1] << "\n";
+        daemon.run();
+        runningDaemon = nullptr;
+        ANGELITA128_Daemon::showStats(daemon.stats());
+    }
+    catch (const ANGELITA128_Exception& err) {
+        std::cout << err.what() << "\n";
+        exit(1);
+    }
+    return 0;
+}
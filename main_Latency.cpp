@@ -0,0 +1,106 @@
+/*
+    This is part of the ANGELITA128 encryption system, the latency main for the small message fast path
+    Copyright (C) 2022 stringzzz, Ghostwarez Co.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+
+Latency command line, times encryptSmall/decryptSmall on 16 to 256 byte messages with one preset key
+
+Usage:
+    ANGELITA128_Latency [iterations]
+
+Each call is timed on its own with steady_clock, and the 50th and 99th percentiles are shown in nanoseconds
+for each mode and message size. The clock read itself is included, so very small numbers are slightly high.
+
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <algorithm>
+#include "ANGELITA128.h"
+
+static void showLatency(const std::string& label, std::vector<std::uint64_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+    std::uint64_t p50 = samples[samples.size() / 2];
+    std::uint64_t p99 = samples[samples.size() * 99 / 100];
+    std::cout << label << "\tp50 " << p50 << " ns\tp99 " << p99 << " ns\n";
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        srand(time(0)); //Do here, not in functions
+        ANGELITA128 a1;
+        a1.setKeyH("e5077dce18a81e4e80a6df19b64dcf25");
+
+        size_t iterations = 100000;
+        if (argc > 1) {
+            iterations = std::stoul(argv[1]);
+        }
+        if (iterations == 0) {
+            std::cout << "Usage: ANGELITA128_Latency [iterations]\n";
+            return 1;
+        }
+
+        std::array<unsigned char, 16> IV;
+        for (unsigned int i = 0; i < 16; i++) {
+            IV[i] = rand() % 256;
+        }
+        std::array<std::uint8_t, 256> plaintext;
+        std::array<std::uint8_t, 272> ciphertext;
+        std::array<std::uint8_t, 272> decrypted;
+        for (unsigned int i = 0; i < 256; i++) {
+            plaintext[i] = rand() % 256;
+        }
+
+        std::vector<std::uint64_t> encryptSamples(iterations);
+        std::vector<std::uint64_t> decryptSamples(iterations);
+        const ANGELITA128_Mode modes[3] = {ANGELITA128_Mode::ECB, ANGELITA128_Mode::CBC, ANGELITA128_Mode::CTR};
+        const std::string modeNames[3] = {"ecb", "cbc", "ctr"};
+        const size_t sizes[4] = {16, 64, 128, 256};
+        for (unsigned int m = 0; m < 3; m++) {
+            for (size_t size : sizes) {
+                for (size_t i = 0; i < iterations; i++) {
+                    size_t ciphertextLength = 0;
+                    size_t decryptedLength = 0;
+                    auto start = std::chrono::steady_clock::now();
+                    ANGELITA128_Status status = a1.encryptSmall(std::span<const std::uint8_t>(plaintext.data(), size), ciphertext, ciphertextLength, modes[m], IV);
+                    auto middle = std::chrono::steady_clock::now();
+                    if (status == ANGELITA128_Status::OK) {
+                        status = a1.decryptSmall(std::span<const std::uint8_t>(ciphertext.data(), ciphertextLength), decrypted, decryptedLength, modes[m], IV);
+                    }
+                    auto end = std::chrono::steady_clock::now();
+                    if (status != ANGELITA128_Status::OK || decryptedLength != size) {
+                        std::cout << "Round trip failed: " << ANGELITA128::statusMessage(status) << "\n";
+                        return 1;
+                    }
+                    encryptSamples[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count();
+                    decryptSamples[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count();
+                }
+                showLatency(modeNames[m] + " encrypt " + std::to_string(size) + " B", encryptSamples);
+                showLatency(modeNames[m] + " decrypt " + std::to_string(size) + " B", decryptSamples);
+            }
+        }
+    }
+    catch (const ANGELITA128_Exception& err) {
+        std::cout << err.what() << "\n";
+        exit(1);
+    }
+    return 0;
+}